@@ -14,19 +14,62 @@
 #include <Arduino.h>
 
 #include "lcd.h"
+#include "lcd_print.h"
+
+// Readings over 10 are shown as text on the left, and every reading is
+// charted on the right. The text and graphics are shown together, so each
+// readout is kept to the 8 columns left of the chart.
+#define READOUT_COLS 8
+
+LcdPrint lcd;
+static chart_t chart;
+static uint8_t chart_spans[2 * (LCD_WIDTH / 2)];
 
 void setup(void) {
     Serial.begin(57600); //  setup serial
+    spi_init();
+    _delay_ms(20);
+    lcd_reset();
+    lcd.begin();
+    display_clear();
+    chart_init(&chart, LCD_WIDTH / 2, 0, LCD_WIDTH / 2, LCD_HEIGHT, 0, 1023,
+            chart_spans);
+    display_refresh();
 }
 
 void loop(void) {
     static int missed = 0;
     int v = analogRead(4);
+
+    // Send in the background, picking up every sample drawn since the
+    // last frame
+    chart_add(&chart, v);
+    if (!display_busy()) {
+        display_refresh_dirty_async();
+    }
+
     if (v > 10) {
         Serial.print(missed);
         Serial.print(": ");
         Serial.print(v);
         Serial.println();
+        // The text goes out between chart frames, with the basic
+        // instructions. Graphics stay on.
+        while (display_busy()) {
+            // chart frame still going
+        }
+        lcd_instruction(0b00110000); // 8 bit data, basic instructions
+        // Cut or padded to the readout's width, a line at a time
+        static uint8_t line = 0;
+        char buf[READOUT_COLS + 1];
+        snprintf(buf, sizeof(buf), "%d: %d", missed, v);
+        uint8_t n = strlen(buf);
+        memset(buf + n, ' ', READOUT_COLS - n);
+        buf[READOUT_COLS] = 0;
+        lcd.setCursor(line, 0);
+        lcd.print(buf);
+        lcd.flush();
+        line = (line + 1) % LCD_TEXT_LINES;
         missed = 0;
     } else {
         delay(50);
@@ -29,22 +29,156 @@
 #include <avr/pgmspace.h>
 #include <inttypes.h>
 #include <stdbool.h>
+#include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
 #include <util/delay.h>
 
 #include "lcd.h"
+#include "splash.h"
 
 static char string_1[] PROGMEM = "Hello, World!";
+#if LCD_TIMING == LCD_TIMING_TABLE
+static char timing_name[] PROGMEM = "Table timing";
+#else
+static char timing_name[] PROGMEM = "Fixed timing";
+#endif
+#if LCD_TRANSPORT == LCD_TRANSPORT_USART
+static char transport_name[] PROGMEM = " USART";
+#else
+static char transport_name[] PROGMEM = " SPI";
+#endif
+static char cycles_name[] PROGMEM = " cyc";
+static char frame_name[] PROGMEM = "Frame cycles";
+static char fixed_name[] PROGMEM = "Fixed ";
+static char table_name[] PROGMEM = "Table ";
+static char saved_name[] PROGMEM = "Saved ";
+static char byte_name[] PROGMEM = "B/s byte ";
+static char block_name[] PROGMEM = "B/s block ";
 
+// 16x16 face, two bytes per row
+static const uint8_t smiley[] PROGMEM = {
+    0x07, 0xe0, 0x18, 0x18, 0x20, 0x04, 0x40, 0x02,
+    0x4c, 0x32, 0x8c, 0x31, 0x80, 0x01, 0x80, 0x01,
+    0x80, 0x01, 0x90, 0x09, 0x88, 0x11, 0x47, 0xe2,
+    0x40, 0x02, 0x20, 0x04, 0x18, 0x18, 0x07, 0xe0,
+};
 
-// Checker board made by direct manipulation of display ram
+// 16x16 text mode glyphs: a heart beating, and a battery running down
+static const uint8_t heart[] PROGMEM = {
+    0x00, 0x00, 0x00, 0x00, 0x1c, 0x38, 0x3e, 0x7c,
+    0x7f, 0xfe, 0x7f, 0xfe, 0x7f, 0xfe, 0x3f, 0xfc,
+    0x3f, 0xfc, 0x1f, 0xf8, 0x0f, 0xf0, 0x07, 0xe0,
+    0x03, 0xc0, 0x01, 0x80, 0x00, 0x00, 0x00, 0x00,
+};
+
+static const uint8_t heart_small[] PROGMEM = {
+    0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+    0x0c, 0x30, 0x1e, 0x78, 0x1f, 0xf8, 0x1f, 0xf8,
+    0x0f, 0xf0, 0x07, 0xe0, 0x03, 0xc0, 0x01, 0x80,
+    0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+};
+
+static const uint8_t battery_full[] PROGMEM = {
+    0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x3f, 0xf8,
+    0x20, 0x08, 0x2f, 0xe8, 0x2f, 0xee, 0x2f, 0xee,
+    0x2f, 0xee, 0x2f, 0xee, 0x2f, 0xe8, 0x20, 0x08,
+    0x3f, 0xf8, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+};
+
+static const uint8_t battery_half[] PROGMEM = {
+    0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x3f, 0xf8,
+    0x20, 0x08, 0x2f, 0x08, 0x2f, 0x0e, 0x2f, 0x0e,
+    0x2f, 0x0e, 0x2f, 0x0e, 0x2f, 0x08, 0x20, 0x08,
+    0x3f, 0xf8, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+};
+
+static const uint8_t battery_empty[] PROGMEM = {
+    0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x3f, 0xf8,
+    0x20, 0x08, 0x20, 0x08, 0x20, 0x0e, 0x20, 0x0e,
+    0x20, 0x0e, 0x20, 0x0e, 0x20, 0x08, 0x20, 0x08,
+    0x3f, 0xf8, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+};
+
+// A status page in text mode, kept in t_buffer
+static void status_setup() {
+    lcd_text_reset();
+    lcd_glyph_reset();
+    lcd_text_printf_p(0, 0, PSTR("Status"));
+    lcd_text_printf_p(3, 0, timing_name);
+}
+
+static void status_step(uint16_t t) {
+    lcd_text_printf_p(1, 0, PSTR("Up %02u:%02u"), (unsigned) (t / 60),
+            (unsigned) (t % 60));
+    lcd_text_printf_p(2, 0, PSTR("Count %5u"), (unsigned) (t * 7));
+    // The glyphs stay in CGRAM, so only a new battery level is loaded
+    lcd_text_glyph_p(0, 14, t & 1 ? heart_small : heart);
+    lcd_text_glyph_p(1, 14, t < 40 ? battery_full
+            : t < 80 ? battery_half : battery_empty);
+}
+
+// Each update changes a digit or two and the heart, and only the cells
+// holding them are sent
+void demo_status() {
+    lcd_reset();
+    status_setup();
+    for (uint16_t t = 0; t < 120; t++) {
+        status_step(t);
+        lcd_text_flush();
+        _delay_ms(100);
+    }
+}
+
+static void draw_splash() {
+    display_image_p(splash, 0, 0);
+}
+
+// The splash screen sent straight from PROGMEM to GDRAM, then unpacked
+// into d_buffer and sent from there
+void demo_splash() {
+    lcd_image_p(splash);
+    _delay_ms(1000);
+#if LCD_BAND_ROWS
+    display_render(draw_splash);
+#else
+    draw_splash();
+    display_refresh();
+#endif
+    _delay_ms(1000);
+}
+
+#if LCD_BAND_ROWS
+// The demos below need the whole screen in d_buffer. When rendering in
+// bands, this one draws its frames through display_render() instead.
+static uint8_t scene_t;
+
+// Circles, lines, a sprite and text, drawn again for every band
+static void draw_scene() {
+    display_text_p(&font_small, 4, 2, string_1, DISPLAY_OR);
+    for (uint8_t j = 0; j < 4; j++) {
+        display_line(0, j * 16 + (scene_t & 15), LCD_WIDTH - 1,
+                LCD_HEIGHT - 1 - j * 16);
+    }
+    display_circle(LCD_WIDTH / 2, LCD_HEIGHT / 2, 10 + scene_t % 20);
+    display_fill_arc(LCD_WIDTH / 2, LCD_HEIGHT / 2, 8, 0, scene_t * 6);
+    display_blit_p(smiley, scene_t * 2 - 16, LCD_HEIGHT - 24, 16, 16,
+            DISPLAY_XOR);
+}
+
+void demo_bands() {
+    for (uint8_t t = 0; t < 60; t++) {
+        scene_t = t;
+        display_render(draw_scene);
+    }
+}
+#else
+// Checker board of 4 pixel squares made with rectangle fills
 void demo_checker_board() {
-    // Checker board
     display_clear();
-    for (int i = 0; i < 64; i++) {
-        for (int j = 0; j < 16; j++) {
-            d_buffer[i * 16 + j] = (i & 4) ? 0xf0 : 0x0f;
+    for (uint8_t y = 0; y < LCD_HEIGHT; y += 4) {
+        for (int x = (y & 4) ? 0 : 4; x < LCD_WIDTH; x += 8) {
+            display_fill_rect(x, y, 4, 4);
         }
     }
 
@@ -57,11 +191,12 @@ void demo_pixel_set() {
     // Lines with line algorithm
     // diagonal line down and up
     display_clear();
-    for (int x = 0; x < 128; x++) {
-        if (x < 64) {
-            display_set(x, x);
+    for (int x = 0; x < LCD_WIDTH; x++) {
+        int y = x % (2 * LCD_HEIGHT);
+        if (y < LCD_HEIGHT) {
+            display_set(x, y);
         } else {
-            display_set(x, 127 - x);
+            display_set(x, 2 * LCD_HEIGHT - 1 - y);
         }
     }
 
@@ -83,6 +218,10 @@ void demo_lines() {
         y1s[t] = 1;
     }
 
+    // Start from a blank screen so only changes need be sent
+    display_clear();
+    display_refresh();
+
     // Move the lines aound
     for (int t = 0; t < 250; t++) {
         display_clear();
@@ -108,12 +247,16 @@ void demo_lines() {
         if (v < 0) { v = 0; dv = (rand() & 3) + 2; } \
         if (v >= max_v) { v = max_v - 1; dv = -(rand() & 3) - 2; } \
 }
-        limit(x0s[0], dx0, 128);
-        limit(x1s[0], dx1, 128);
-        limit(y0s[0], dy0, 64);
-        limit(y1s[0], dy1, 64);
+        limit(x0s[0], dx0, LCD_WIDTH);
+        limit(x1s[0], dx1, LCD_WIDTH);
+        limit(y0s[0], dy0, LCD_HEIGHT);
+        limit(y1s[0], dy1, LCD_HEIGHT);
 #undef limit
-        display_refresh();
+#if LCD_DOUBLE_BUFFER
+        display_swap();
+#else
+        display_refresh_dirty();
+#endif
     }
 }
 
@@ -121,13 +264,371 @@ void demo_circles() {
     for (int i = 0; i < 100; i += 2) {
         display_clear();
         for (int j = 0; j < 6; j++) {
-            display_circle(64 + (i - 50) / 6 - j * (i - 50) / 10, 32 + j,
-                    j * 12 + 5);
+            display_circle(LCD_WIDTH / 2 + (i - 50) / 6 - j * (i - 50) / 10,
+                    LCD_HEIGHT / 2 + j, j * 12 + 5);
         }
         display_refresh();
     }
 }
 
+// Faces bouncing around and off the edges, drawn with bitmap copies
+void demo_sprites() {
+    int x = 0, y = 10, dx = 3, dy = 2;
+
+    display_clear();
+    display_refresh();
+    for (int t = 0; t < 100; t++) {
+        display_clear();
+        display_blit_p(smiley, x, y, 16, 16, DISPLAY_OR);
+        display_blit_p(smiley, LCD_WIDTH - 8 - x, LCD_HEIGHT - 14 - y, 16, 16,
+                DISPLAY_OR);
+        display_blit_p(smiley, x + 8, LCD_HEIGHT - 20 - y, 16, 16, DISPLAY_XOR);
+        x += dx;
+        y += dy;
+        if (x < -8 || x > LCD_WIDTH - 8) {
+            dx = -dx;
+        }
+        if (y < -8 || y > LCD_HEIGHT - 8) {
+            dy = -dy;
+        }
+        display_refresh_dirty();
+    }
+}
+
+// Text drawn into the graphics buffer, with a counter and progress bar
+void demo_text() {
+    char buf[7];
+
+    display_clear();
+    int w = display_text_width_p(&font_small, string_1);
+    display_text_p(&font_small, (LCD_WIDTH - w) / 2, 4, string_1, DISPLAY_OR);
+    display_span(0, LCD_WIDTH - 1, 14);
+    display_text_p(&font_small, 4, 24, PSTR("Count:"), DISPLAY_OR);
+    display_text_p(&font_small, 4, 36, PSTR("Type quickly, Ava!"), DISPLAY_OR);
+    display_refresh();
+
+    for (int t = 0; t <= 100; t++) {
+        // Right aligned number, replacing the last one
+        itoa(t * 7, buf, 10);
+        display_clear_rect(64, 24, 40, 8);
+        display_text(&font_small, 100 - display_text_width(&font_small, buf),
+                24, buf, DISPLAY_COPY);
+        display_fill_rect(4, 52, t * 120 / 100, 6);
+        display_refresh_rect(64, 24, 40, 8);
+        display_refresh_rect(4, 52, 120, 6);
+    }
+}
+
+// A dial gauge with a filled sector for the reading
+void demo_gauge() {
+    display_clear();
+    display_arc(64, 40, 36, 180, 360);
+    display_hline(24, 41, 81);
+    display_refresh();
+
+    for (int t = 0; t <= 180; t += 3) {
+        display_clear_rect(34, 10, 61, 31);
+        display_fill_arc(64, 40, 30, 180, 180 + t);
+        display_fill_ellipse(64, 40, 8, 4);
+        display_refresh_dirty();
+    }
+}
+
+// A mostly still dashboard, kept as a retained scene
+static char dash_count[7];
+static uint8_t dash_needle, dash_bar, dash_text;
+
+static void dashboard_setup() {
+    scene_clear();
+    scene_text_p(&font_small, 4, 2, string_1);
+    scene_rect(0, 12, LCD_WIDTH, 1);
+    scene_circle(32, 40, 20);
+    scene_text_p(&font_small, 64, 20, PSTR("Count:"));
+    strcpy(dash_count, "0");
+    dash_text = scene_text(&font_small, 100, 20, dash_count);
+    scene_line(64, 34, 103, 34);
+    scene_line(64, 42, 103, 42);
+    scene_line(64, 34, 64, 42);
+    scene_line(103, 34, 103, 42);
+    scene_bitmap_p(smiley, 108, 44, 16, 16);
+    dash_needle = scene_line(32, 40, 14, 24);
+    dash_bar = SCENE_NONE;
+}
+
+// Swing the needle, count up and grow the bar every fourth frame
+static void dashboard_step(uint8_t t) {
+    uint8_t swing = t % 72;
+    scene_remove(dash_needle);
+    dash_needle = scene_line(32, 40, 14 + (swing < 36 ? swing : 72 - swing),
+            24);
+    itoa(t * 7, dash_count, 10);
+    scene_changed(dash_text);
+    if (!(t & 3)) {
+        scene_remove(dash_bar);
+        dash_bar = scene_rect(66, 36, t * 36 / 100, 5);
+    }
+}
+
+// The dashboard, where each frame changes a line, a number and a bar.
+// Only the items near those are drawn again, and only the words that
+// changed are sent.
+void demo_scene() {
+    display_clear();
+    display_refresh();
+    dashboard_setup();
+    for (uint8_t t = 0; t < 100; t++) {
+        dashboard_step(t);
+        scene_update();
+        display_refresh_dirty();
+    }
+}
+
+// A log scrolling up a line of text at a time. The controller moves the
+// picture, so each new line costs just the rows it scrolls into view.
+void demo_scroll() {
+    char buf[7];
+
+    display_clear();
+    display_refresh();
+    for (int t = 0; t < 40; t++) {
+        display_scroll(9);
+        int x = display_text_p(&font_small, 2, LCD_HEIGHT - 9,
+                PSTR("Log line "), DISPLAY_OR);
+        display_text(&font_small, x, LCD_HEIGHT - 9, itoa(t, buf, 10),
+                DISPLAY_OR);
+        display_refresh_dirty();
+    }
+}
+
+// A noisy triangle wave swept across a strip chart, refreshed after each
+// sample
+static uint8_t chart_spans[2 * 120];
+
+void demo_chart() {
+    chart_t chart;
+
+    display_clear();
+    display_text_p(&font_small, 4, 0, PSTR("Chart"), DISPLAY_OR);
+    chart_init(&chart, 4, 10, 120, LCD_HEIGHT - 10, 0, 271, chart_spans);
+    display_refresh();
+    for (int t = 0; t < 300; t++) {
+        chart_add(&chart, abs((t * 9) % 512 - 256) + (rand() & 15));
+        display_refresh_dirty();
+    }
+}
+
+//
+// Gray of a heat map at x, y with two warm spots, which move with t.
+// Warmer is darker.
+static uint8_t heat(uint8_t x, uint8_t y, uint8_t t) {
+    static const uint8_t spots[2][2] = { { 20, 24 }, { 44, 40 } };
+    uint16_t warmth = 0;
+    for (uint8_t i = 0; i < 2; i++) {
+        int dx = x - spots[i][0] - (i ? -t : t);
+        int dy = y - spots[i][1];
+        warmth += 255U * 160 / (160 + dx * dx + dy * dy);
+    }
+    return warmth > 255 ? 0 : 255 - warmth;
+}
+
+// The same heat map dithered by Bayer on the left and Floyd-Steinberg on
+// the right, a row at a time
+void demo_dither() {
+    static int16_t errors[LCD_WIDTH / 2];
+    uint8_t gray[LCD_WIDTH / 2];
+    dither_t bayer, floyd;
+
+    display_clear();
+    for (uint8_t t = 0; t < 20; t++) {
+        dither_begin(&bayer, DITHER_BAYER, 0, 0, LCD_WIDTH / 2, NULL);
+        dither_begin(&floyd, DITHER_FLOYD, LCD_WIDTH / 2, 0, LCD_WIDTH / 2,
+                errors);
+        for (uint8_t y = 0; y < LCD_HEIGHT; y++) {
+            for (uint8_t x = 0; x < LCD_WIDTH / 2; x++) {
+                gray[x] = heat(x, y, t);
+            }
+            dither_row(&bayer, gray);
+            dither_row(&floyd, gray);
+        }
+        display_refresh_dirty();
+    }
+}
+
+#if LCD_GRAY_ROWS
+#define GRAY_HZ 60
+
+// Bars of each shade, and a level meter, in the gray rows
+static void gray_setup() {
+    display_clear();
+    for (uint8_t shade = 0; shade < 4; shade++) {
+        display_fill_shade(shade * (LCD_WIDTH / 4), 0, LCD_WIDTH / 4, 12,
+                shade);
+    }
+    display_text_p(&font_small, 4, LCD_GRAY_ROWS + 2, PSTR("Gray"),
+            DISPLAY_OR);
+}
+
+static void gray_step(uint8_t t) {
+    uint8_t level = t % (LCD_WIDTH - 8);
+    display_fill_shade(4, 16, level, 8, 3);
+    display_fill_shade(4 + level, 16, LCD_WIDTH - 8 - level, 8, 1);
+}
+
+// The level meter moving in gray, with the plane rate and how busy the
+// bus is kept shown below
+void demo_gray() {
+    display_gray_counters_t c;
+    char line[32];
+
+    gray_setup();
+    display_gray_start(GRAY_HZ);
+    for (uint16_t t = 0; t < 300; t++) {
+        gray_step(t);
+        _delay_ms(20);
+        if (t % 50 == 49) {
+            display_gray_counters(&c);
+            if (!c.ticks) {
+                continue;
+            }
+            snprintf(line, sizeof(line), "%u fps, bus %u%%",
+                    (unsigned) ((uint32_t) c.frames * GRAY_HZ / c.ticks),
+                    (unsigned) (c.bus_us / (c.ticks * (10000UL / GRAY_HZ))));
+            display_clear_rect(4, LCD_GRAY_ROWS + 12, LCD_WIDTH - 8, 10);
+            display_text(&font_small, 4, LCD_GRAY_ROWS + 12, line,
+                    DISPLAY_OR);
+        }
+    }
+    display_gray_stop();
+}
+#endif
+
+#endif
+
+// Timer1 at F_CPU / 64 runs for 262ms at 16MHz before overflowing
+static void timer_start() {
+    TCCR1A = 0;
+    TCCR1B = _BV(CS11) | _BV(CS10);
+    TCNT1 = 0;
+}
+
+static uint32_t timer_cycles() {
+    uint32_t cycles = TCNT1 * 64UL;
+    TCCR1B = 0;
+    return cycles;
+}
+
+//
+// Send one transfer, then wait as LCD_TIMING_TABLE would if 'table' is set,
+// or else as LCD_TIMING_FIXED would. Each branch passes _delay_us a
+// constant.
+static void timed_transfer(uint8_t sync, uint8_t b, bool table) {
+    spi_send(sync);
+    spi_send(b & 0xf0);
+    spi_send(b << 4);
+    spi_flush();
+    bool data = sync == 0b11111010;
+    if (table) {
+        if (data) {
+            _delay_us(LCD_DATA_US);
+        } else {
+            _delay_us(LCD_ADDRESS_US);
+        }
+    } else {
+        if (data) {
+            _delay_us(40);
+        } else {
+            _delay_us(72);
+        }
+    }
+}
+
+//
+// Cycles to send a blank frame, a row at a time, with the waits of one
+// timing mode or the other. Needs graphics mode set.
+static uint32_t timed_frame(bool table) {
+    timer_start();
+    for (uint8_t y = 0; y < LCD_HEIGHT; y++) {
+        timed_transfer(0b11111000, 0b10000000 | (y % LCD_GDRAM_LINES), table);
+        timed_transfer(0b11111000,
+                0b10000000 | (y < LCD_GDRAM_LINES ? 0 : LCD_ROW_WORDS), table);
+        for (uint8_t i = 0; i < LCD_ROW_BYTES; i++) {
+            timed_transfer(0b11111010, 0, table);
+        }
+    }
+    return timer_cycles();
+}
+
+// Time a full frame refresh with Timer1 and show it in CPU cycles, then
+// the data rate of 256 bytes sent one at a time and as a block. A second
+// screen times the same frame with the fixed and the table waits, side by
+// side. Build with -DLCD_TIMING=LCD_TIMING_TABLE to run everything else on
+// the table, or with -DLCD_TRANSPORT=LCD_TRANSPORT_USART to compare the
+// transports.
+void demo_benchmark() {
+#if LCD_BAND_ROWS
+    timer_start();
+    display_render(NULL);
+    uint32_t cycles = timer_cycles();
+#else
+    display_clear();
+
+    timer_start();
+    display_refresh();
+    uint32_t cycles = timer_cycles();
+#endif
+
+    // Blank, so these leave the screen blank wherever the address counter
+    // has got to
+    uint8_t blank[32];
+    memset(blank, 0, sizeof(blank));
+    timer_start();
+    for (uint16_t i = 0; i < 256; i++) {
+        lcd_data(blank[i & 31]);
+    }
+    uint32_t byte_cycles = timer_cycles();
+
+    timer_start();
+    for (uint8_t i = 0; i < 8; i++) {
+        lcd_data_block(blank, sizeof(blank));
+    }
+    uint32_t block_cycles = timer_cycles();
+
+    // Still in graphics mode, after the frame above
+    uint32_t fixed_cycles = timed_frame(false);
+    uint32_t table_cycles = timed_frame(true);
+
+    char buf[11];
+    lcd_reset();
+    lcd_set_cursor(0, 0);
+    lcd_send_str_p(timing_name);
+    lcd_set_cursor(1, 0);
+    lcd_send_str(ultoa(cycles, buf, 10));
+    lcd_send_str_p(cycles_name);
+    lcd_send_str_p(transport_name);
+    lcd_set_cursor(2, 0);
+    lcd_send_str_p(byte_name);
+    lcd_send_str(ultoa(256 * F_CPU / byte_cycles, buf, 10));
+    lcd_set_cursor(3, 0);
+    lcd_send_str_p(block_name);
+    lcd_send_str(ultoa(256 * F_CPU / block_cycles, buf, 10));
+    _delay_ms(3000);
+
+    lcd_clear();
+    lcd_set_cursor(0, 0);
+    lcd_send_str_p(frame_name);
+    lcd_set_cursor(1, 0);
+    lcd_send_str_p(fixed_name);
+    lcd_send_str(ultoa(fixed_cycles, buf, 10));
+    lcd_set_cursor(2, 0);
+    lcd_send_str_p(table_name);
+    lcd_send_str(ultoa(table_cycles, buf, 10));
+    lcd_set_cursor(3, 0);
+    lcd_send_str_p(saved_name);
+    lcd_send_str(ultoa(100 - table_cycles * 100 / fixed_cycles, buf, 10));
+    lcd_send_str("%");
+    _delay_ms(3000);
+}
+
 int main(int argc, char **argv) {
     spi_init();
     _delay_ms(20);
@@ -141,10 +642,27 @@ int main(int argc, char **argv) {
         _delay_ms(3000);
         lcd_clear();
 
+        demo_status();
+        demo_splash();
+#if LCD_BAND_ROWS
+        demo_bands();
+#else
         demo_circles();
         demo_lines();
         demo_pixel_set();
         demo_checker_board();
+        demo_sprites();
+        demo_text();
+        demo_gauge();
+        demo_scene();
+        demo_scroll();
+        demo_chart();
+        demo_dither();
+#if LCD_GRAY_ROWS
+        demo_gray();
+#endif
+#endif
+        demo_benchmark();
     }
 }
 
@@ -0,0 +1,61 @@
+// splash.pbm: 128x64, 1024 bytes packed into 677. Made by imgconv.
+static const uint8_t splash[] PROGMEM = {
+    16, 64,
+    0xf1, 0xff, 0x00, 0xa0, 0xf3, 0x00, 0x00, 0x05, 0xf1, 0xff, 0x00, 0xa0,
+    0xf3, 0x00, 0x01, 0x05, 0xa0, 0xf3, 0x00, 0x01, 0x05, 0xa0, 0xf3, 0x00,
+    0x01, 0x05, 0xa0, 0xf3, 0x00, 0x01, 0x05, 0xa0, 0xf3, 0x00, 0x05, 0x05,
+    0xa0, 0x00, 0x00, 0x0f, 0xf8, 0xf7, 0x00, 0x06, 0x05, 0xa0, 0x00, 0x00,
+    0xf0, 0x07, 0x80, 0xf8, 0x00, 0x06, 0x05, 0xa0, 0x00, 0x03, 0x00, 0x00,
+    0x60, 0xf8, 0x00, 0x06, 0x05, 0xa0, 0x00, 0x0c, 0x00, 0x00, 0x18, 0xf8,
+    0x00, 0x06, 0x05, 0xa0, 0x00, 0x30, 0x0f, 0xf8, 0x06, 0xf8, 0x00, 0x06,
+    0x05, 0xa0, 0x00, 0x40, 0x7f, 0xff, 0x01, 0xf8, 0x00, 0x07, 0x05, 0xa0,
+    0x00, 0x81, 0xff, 0xff, 0xc0, 0x80, 0xf9, 0x00, 0x07, 0x05, 0xa0, 0x01,
+    0x07, 0xff, 0xff, 0xf0, 0x40, 0xf9, 0x00, 0x07, 0x05, 0xa0, 0x02, 0x0f,
+    0xff, 0xff, 0xf8, 0x20, 0xf9, 0x00, 0x07, 0x05, 0xa0, 0x04, 0x1f, 0xff,
+    0xff, 0xfc, 0x10, 0xf9, 0x00, 0x13, 0x05, 0xa0, 0x08, 0x3f, 0xff, 0xff,
+    0xfe, 0x08, 0x00, 0x7b, 0xef, 0x9c, 0x71, 0xc0, 0x00, 0x00, 0x05, 0xa0,
+    0x08, 0x7f, 0xfe, 0xff, 0x0b, 0x08, 0x00, 0x80, 0x80, 0xa2, 0x8a, 0x20,
+    0x00, 0x00, 0x05, 0xa0, 0x10, 0xfd, 0xff, 0x0b, 0x84, 0x00, 0x80, 0x81,
+    0x22, 0x0a, 0x60, 0x00, 0x00, 0x05, 0xa0, 0x11, 0xfd, 0xff, 0x0b, 0xc4,
+    0x00, 0x70, 0x82, 0x1e, 0x32, 0xa0, 0x00, 0x00, 0x05, 0xa0, 0x21, 0xfd,
+    0xff, 0x0b, 0xc2, 0x00, 0x08, 0x84, 0x02, 0x43, 0x20, 0x00, 0x00, 0x05,
+    0xa0, 0x23, 0xfd, 0xff, 0x0b, 0xe2, 0x00, 0x08, 0x84, 0x04, 0x82, 0x20,
+    0x00, 0x00, 0x05, 0xa0, 0x43, 0xfd, 0xff, 0x0b, 0xe1, 0x00, 0xf0, 0x84,
+    0x18, 0xf9, 0xc0, 0x00, 0x00, 0x05, 0xa0, 0x47, 0xfd, 0xff, 0x00, 0xf1,
+    0xf9, 0x00, 0x02, 0x05, 0xa0, 0x47, 0xfd, 0xff, 0x00, 0xf1, 0xf9, 0x00,
+    0x02, 0x05, 0xa0, 0x47, 0xfd, 0xff, 0x00, 0xf1, 0xf9, 0x00, 0x02, 0x05,
+    0xa0, 0x8f, 0xfd, 0xff, 0x01, 0xf8, 0x80, 0xfa, 0x00, 0x02, 0x05, 0xa0,
+    0x8f, 0xfd, 0xff, 0x01, 0xf8, 0x80, 0xfa, 0x00, 0x0b, 0x05, 0xa0, 0x8f,
+    0xc0, 0x1f, 0xfc, 0x01, 0xf8, 0x80, 0x80, 0x14, 0xa0, 0xfd, 0x00, 0x0b,
+    0x05, 0xa0, 0x8f, 0xc0, 0x03, 0xe0, 0x01, 0xf8, 0x80, 0x80, 0x14, 0x20,
+    0xfd, 0x00, 0x0b, 0x05, 0xa0, 0x8f, 0xc0, 0x00, 0x80, 0x01, 0xf8, 0x80,
+    0x8e, 0x74, 0xb8, 0xfd, 0x00, 0x0b, 0x05, 0xa0, 0x8f, 0xc0, 0x00, 0x00,
+    0x01, 0xf8, 0x80, 0x90, 0x94, 0xa4, 0xfd, 0x00, 0x0b, 0x05, 0xa0, 0x8f,
+    0xc0, 0x00, 0x00, 0x01, 0xf8, 0x80, 0x90, 0x94, 0xa4, 0xfd, 0x00, 0x02,
+    0x05, 0xa0, 0x8f, 0xfd, 0xff, 0x04, 0xf8, 0x80, 0x90, 0x94, 0xa4, 0xfd,
+    0x00, 0x02, 0x05, 0xa0, 0x8f, 0xfd, 0xff, 0x04, 0xf8, 0x80, 0x4e, 0x72,
+    0xb8, 0xfd, 0x00, 0x02, 0x05, 0xa0, 0x47, 0xfd, 0xff, 0x00, 0xf1, 0xf9,
+    0x00, 0x02, 0x05, 0xa0, 0x47, 0xfd, 0xff, 0x00, 0xf1, 0xf9, 0x00, 0x02,
+    0x05, 0xa0, 0x47, 0xfd, 0xff, 0x00, 0xf1, 0xf9, 0x00, 0x02, 0x05, 0xa0,
+    0x43, 0xfd, 0xff, 0x00, 0xe1, 0xf9, 0x00, 0x02, 0x05, 0xa0, 0x23, 0xfd,
+    0xff, 0x00, 0xe2, 0xf9, 0x00, 0x02, 0x05, 0xa0, 0x21, 0xfd, 0xff, 0x01,
+    0xc2, 0x00, 0xfb, 0xff, 0x03, 0xfe, 0x05, 0xa0, 0x11, 0xfd, 0xff, 0x00,
+    0xc4, 0xf9, 0x00, 0x02, 0x05, 0xa0, 0x10, 0xfd, 0xff, 0x00, 0x84, 0xf9,
+    0x00, 0x03, 0x05, 0xa0, 0x08, 0x7f, 0xfe, 0xff, 0x00, 0x08, 0xf9, 0x00,
+    0x76, 0x05, 0xa0, 0x08, 0x3f, 0xff, 0xff, 0xfe, 0x08, 0x00, 0x47, 0x1c,
+    0x00, 0x01, 0x82, 0x00, 0x00, 0x05, 0xa0, 0x04, 0x1f, 0xff, 0xff, 0xfc,
+    0x10, 0x00, 0xc8, 0xa2, 0x00, 0x02, 0x06, 0x00, 0x00, 0x05, 0xa0, 0x02,
+    0x0f, 0xff, 0xff, 0xf8, 0x20, 0x00, 0x40, 0xa2, 0x09, 0x04, 0x0a, 0x00,
+    0x00, 0x05, 0xa0, 0x01, 0x07, 0xff, 0xff, 0xf0, 0x40, 0x00, 0x43, 0x1c,
+    0x09, 0x07, 0x92, 0x00, 0x00, 0x05, 0xa0, 0x00, 0x81, 0xff, 0xff, 0xc0,
+    0x80, 0x00, 0x44, 0x22, 0x06, 0x04, 0x5f, 0x00, 0x00, 0x05, 0xa0, 0x00,
+    0x40, 0x7f, 0xff, 0x01, 0x00, 0x00, 0x48, 0x22, 0x09, 0x04, 0x42, 0x00,
+    0x00, 0x05, 0xa0, 0x00, 0x30, 0x0f, 0xf8, 0x06, 0x00, 0x00, 0xef, 0x9c,
+    0x09, 0x03, 0x82, 0x00, 0x00, 0x05, 0xa0, 0x00, 0x0c, 0x00, 0x00, 0x18,
+    0xf8, 0x00, 0x06, 0x05, 0xa0, 0x00, 0x03, 0x00, 0x00, 0x60, 0xf8, 0x00,
+    0x06, 0x05, 0xa0, 0x00, 0x00, 0xf0, 0x07, 0x80, 0xf8, 0x00, 0x05, 0x05,
+    0xa0, 0x00, 0x00, 0x0f, 0xf8, 0xf7, 0x00, 0x01, 0x05, 0xa0, 0xf3, 0x00,
+    0x01, 0x05, 0xa0, 0xf3, 0x00, 0x01, 0x05, 0xa0, 0xf3, 0x00, 0x01, 0x05,
+    0xa0, 0xf3, 0x00, 0x00, 0x05, 0xf1, 0xff, 0x00, 0xa0, 0xf3, 0x00, 0x00,
+    0x05, 0xf1, 0xff,
+};
@@ -0,0 +1,74 @@
+/*
+ * Print.h
+ *
+ * Host stand in for the Arduino10 header, with just enough of Print for
+ * lcd_print.h. Strings and numbers reach write() as they do in
+ * Arduino10/Print.cpp: a number or string in one call, and println()'s
+ * '\r' and '\n' one character at a time.
+ */
+
+#ifndef LCDHOST_PRINT_H_
+#define LCDHOST_PRINT_H_
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+
+class Print {
+public:
+    virtual ~Print() {
+    }
+
+    virtual size_t write(uint8_t) = 0;
+
+    size_t write(const char *str) {
+        return write((const uint8_t *) str, strlen(str));
+    }
+
+    virtual size_t write(const uint8_t *buffer, size_t size) {
+        size_t n = 0;
+        while (size--) {
+            n += write(*buffer++);
+        }
+        return n;
+    }
+
+    size_t print(const char str[]) {
+        return write(str);
+    }
+
+    size_t print(char c) {
+        return write((uint8_t) c);
+    }
+
+    size_t print(long n) {
+        char buf[12];
+        snprintf(buf, sizeof(buf), "%ld", n);
+        return write(buf);
+    }
+
+    size_t print(int n) {
+        return print((long) n);
+    }
+
+    size_t println() {
+        size_t n = print('\r');
+        n += print('\n');
+        return n;
+    }
+
+    size_t println(const char str[]) {
+        size_t n = print(str);
+        n += println();
+        return n;
+    }
+
+    size_t println(int n) {
+        size_t s = print(n);
+        s += println();
+        return s;
+    }
+};
+
+#endif /* LCDHOST_PRINT_H_ */
@@ -0,0 +1,15 @@
+/*
+ * avr/interrupt.h
+ *
+ * Host stand in for the avr-libc header. There are no interrupts on the
+ * host, so handlers are ordinary functions.
+ */
+
+#ifndef LCDHOST_AVR_INTERRUPT_H_
+#define LCDHOST_AVR_INTERRUPT_H_
+
+#define ISR(vector) void vector(void)
+#define sei()
+#define cli()
+
+#endif /* LCDHOST_AVR_INTERRUPT_H_ */
@@ -0,0 +1,69 @@
+/*
+ * avr/io.h
+ *
+ * Host stand in for the avr-libc header. Registers are plain variables,
+ * except SPDR, SPSR, UDR0 and UCSR0A, which go through avr_host.c so that
+ * bytes written to the SPI port or USART0 reach the emulated controller.
+ */
+
+#ifndef LCDHOST_AVR_IO_H_
+#define LCDHOST_AVR_IO_H_
+
+#include <stdint.h>
+
+#define _BV(bit) (1 << (bit))
+
+// As on the 1280 and 2560, so that every lcdlib option builds
+#define RAMEND 0x21ff
+
+// SPI
+volatile uint8_t *host_spdr(void);
+volatile uint8_t *host_spsr(void);
+#define SPDR (*host_spdr())
+#define SPSR (*host_spsr())
+extern volatile uint8_t SPCR;
+#define SPIE 7
+#define SPIF 7
+
+// USART0, for LCD_TRANSPORT_USART
+volatile uint8_t *host_udr0(void);
+volatile uint8_t *host_ucsr0a(void);
+#define UDR0 (*host_udr0())
+#define UCSR0A (*host_ucsr0a())
+extern volatile uint8_t UCSR0B, UCSR0C;
+extern volatile uint16_t UBRR0;
+#define UDRE0 5
+#define TXC0 6
+#define TXEN0 3
+#define TXCIE0 6
+#define UMSEL01 7
+#define UMSEL00 6
+#define UCPHA0 1
+#define UCPOL0 0
+
+// Ports
+extern volatile uint8_t DDRB, PORTB, PINB, DDRD, PORTD;
+#define PD1 1
+#define PD4 4
+
+// Timers
+extern volatile uint8_t TCCR1A, TCCR1B, TIFR1, TIMSK1;
+extern volatile uint16_t TCNT1, OCR1A;
+#define CS10 0
+#define CS11 1
+#define WGM12 3
+#define TOV1 0
+#define OCIE1A 1
+extern volatile uint8_t TCCR2A, TCCR2B, OCR2A, TIMSK2, TIFR2, TCNT2;
+#define CS20 0
+#define CS21 1
+#define CS22 2
+#define WGM21 1
+#define OCIE2A 1
+#define OCF2A 1
+
+// avr-libc extensions which the host C library lacks
+char *itoa(int value, char *s, int radix);
+char *ultoa(unsigned long value, char *s, int radix);
+
+#endif /* LCDHOST_AVR_IO_H_ */
@@ -0,0 +1,24 @@
+/*
+ * avr/pgmspace.h
+ *
+ * Host stand in for the avr-libc header. Program memory is ordinary
+ * memory.
+ */
+
+#ifndef LCDHOST_AVR_PGMSPACE_H_
+#define LCDHOST_AVR_PGMSPACE_H_
+
+#include <stdint.h>
+#include <string.h>
+
+#define PROGMEM
+#define PGM_P const char *
+#define PSTR(s) (s)
+#define pgm_read_byte(p) (*(const uint8_t *) (p))
+#define pgm_read_word(p) (*(const uint16_t *) (p))
+#define memcpy_P memcpy
+
+// avr-libc declares this in stdio.h
+#define vsnprintf_P vsnprintf
+
+#endif /* LCDHOST_AVR_PGMSPACE_H_ */
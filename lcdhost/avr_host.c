@@ -0,0 +1,76 @@
+/*
+ * avr_host.c
+ *
+ * Host side definitions for the stand in avr-libc headers.
+ */
+
+#include <avr/io.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <util/delay.h>
+
+#include "st7920.h"
+
+volatile uint8_t SPCR;
+volatile uint8_t DDRB, PORTB, PINB, DDRD, PORTD;
+volatile uint8_t TCCR1A, TCCR1B, TIFR1, TIMSK1;
+volatile uint16_t TCNT1, OCR1A;
+volatile uint8_t TCCR2A, TCCR2B, OCR2A, TIMSK2, TIFR2, TCNT2;
+volatile uint8_t UCSR0B, UCSR0C;
+volatile uint16_t UBRR0;
+
+// SPDR and UDR0 are written through the pointer returned by host_spdr()
+// or host_udr0(), so the byte can only be picked up on the next register
+// access. Both feed the same emulated controller.
+static volatile uint8_t spdr;
+static volatile uint8_t spsr;
+static volatile uint8_t ucsr0a;
+static bool spdr_pending;
+
+void st7920_flush() {
+    if (spdr_pending) {
+        spdr_pending = false;
+        st7920_receive(spdr);
+    }
+}
+
+volatile uint8_t *host_spdr(void) {
+    st7920_flush();
+    spdr_pending = true;
+    return &spdr;
+}
+
+volatile uint8_t *host_spsr(void) {
+    st7920_flush();
+    // Transfers complete at once
+    spsr |= _BV(SPIF);
+    return &spsr;
+}
+
+volatile uint8_t *host_udr0(void) {
+    return host_spdr();
+}
+
+volatile uint8_t *host_ucsr0a(void) {
+    st7920_flush();
+    // Transfers complete at once, leaving the buffer empty
+    ucsr0a |= _BV(UDRE0) | _BV(TXC0);
+    return &ucsr0a;
+}
+
+void host_delay_us(double us) {
+    st7920_flush();
+    st7920.us += us;
+}
+
+char *itoa(int value, char *s, int radix) {
+    (void) radix;
+    sprintf(s, "%d", value);
+    return s;
+}
+
+char *ultoa(unsigned long value, char *s, int radix) {
+    (void) radix;
+    sprintf(s, "%lu", value);
+    return s;
+}
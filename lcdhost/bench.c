@@ -0,0 +1,754 @@
+/*
+ * bench.c
+ *
+ * Runs the lcd demos against the host ST7920 emulator and reports, for each
+ * demo, the bytes sent and the modeled bus time per frame, along with the
+ * bytes a full row by row refresh would have sent. Delays in the
+ * demos themselves are not counted, only those in lcdlib. The stale column
+ * counts pixels on the emulated display which differ from d_buffer at the
+ * end of the demo, and should be 0.
+ *
+ * Build and run from the top of the repository:
+ *
+ *   gcc -std=gnu99 -O2 -DF_CPU=16000000UL -Ilcdhost -Ilcdlib -o lcdbench \
+ *       lcdhost/avr_host.c lcdhost/st7920.c lcdhost/bench.c lcdlib/lcd_*.c
+ *   ./lcdbench [-p dir]
+ *
+ * With -DLCD_BAND_ROWS=n the display is rendered in bands of n rows, and
+ * the single band demo is run instead. The host CPU time to draw its
+ * frame, once per band, is shown along with the RAM the buffers take.
+ *
+ * With -p, the last frame of each demo is written to dir/<demo>.pbm, for
+ * comparing against known good images with cmp.
+ *
+ * Add -DLCD_TIMING=LCD_TIMING_TABLE to model the table driven timing, or
+ * -DLCD_DOUBLE_BUFFER=1 to have demo_lines use display_swap(). Set
+ * LCD_WIDTH and LCD_HEIGHT to run the demos on another panel size.
+ *
+ * -DLCD_TRANSPORT=LCD_TRANSPORT_USART sends through USART0 instead of the
+ * SPI port. The model has no gaps between bytes on either, so the times
+ * match; demo_benchmark on the target measures the difference.
+ *
+ * The modeled data rate of lcd_data_block is then compared with sending
+ * the same bytes one lcd_data call at a time.
+ *
+ * demo_status's text page is sent with lcd_text_flush() and then whole for
+ * each update, to compare the bytes and modeled bus time of the two.
+ *
+ * demo_scene's dashboard is also run drawing each frame from scratch, to
+ * compare the bytes sent and host CPU time with scene_update().
+ *
+ * The splash image is sent by lcd_image_p(), straight from its packed
+ * form, and by display_image_p() and display_refresh(), to compare them.
+ *
+ * display_refresh_async() and display_refresh_dirty_async() send frames of
+ * demo_scroll's log, running the interrupt handlers of lcd_async.c by
+ * hand, and a clear is queued to check it gets the settle of lcd_clear().
+ *
+ * With -DLCD_GRAY_ROWS=n, demo_gray's planes are sent for a number of
+ * Timer1 ticks, running the interrupt handlers of lcd_async.c by hand.
+ * The bytes and modeled bus time of each tick give the fastest rate the
+ * bus could keep up with.
+ *
+ * Last, drawing primitives are timed on the host CPU against
+ * the same drawing done with display_set. The ratio is a guide to the
+ * speedup on the AVR, not a measurement of it.
+ *
+ * The exit status is 1 if any check found stale pixels or characters, or
+ * malformed transfers.
+ */
+
+#include <avr/io.h>
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+#include <util/delay.h>
+
+#include "lcd.h"
+#include "st7920.h"
+
+// The demos, with their own pauses taking no time
+#undef _delay_ms
+#define _delay_ms(ms) ((void) (ms))
+#define main lcd_main
+#include "../lcd/main.c"
+#undef main
+
+typedef struct {
+    const char *name;
+    void (*run)();
+} demo_t;
+
+static const demo_t demos[] = {
+#if LCD_BAND_ROWS
+    { "bands", demo_bands },
+#else
+    { "circles", demo_circles },
+    { "lines", demo_lines },
+    { "pixel_set", demo_pixel_set },
+    { "checker_board", demo_checker_board },
+    { "sprites", demo_sprites },
+    { "text", demo_text },
+    { "gauge", demo_gauge },
+    { "scene", demo_scene },
+    { "scroll", demo_scroll },
+    { "chart", demo_chart },
+    { "splash", demo_splash },
+    { "dither", demo_dither },
+#endif
+};
+
+// Stale pixels or characters and malformed transfers seen by any of the
+// checks. The bench fails if there are any.
+static unsigned long failures;
+
+// Pixels on the display which don't match the rows of d_buffer
+static unsigned stale_rows(uint8_t top, uint8_t rows) {
+    unsigned n = 0;
+    for (uint8_t r = 0; r < rows; r++) {
+        for (unsigned x = 0; x < LCD_WIDTH; x++) {
+            bool set = d_buffer[r * LCD_ROW_BYTES + (x >> 3)]
+                    & (0x80 >> (x & 7));
+            if (set != st7920_pixel(x, top + r)) {
+                n++;
+            }
+        }
+    }
+    return n;
+}
+
+// Pixels on the display which don't match d_buffer. With bands, d_buffer
+// holds only the last band, so each band of the band demo's last frame is
+// drawn again to compare.
+static unsigned stale_pixels() {
+#if LCD_BAND_ROWS
+    unsigned n = 0;
+    for (d_band_top = 0; d_band_top < LCD_HEIGHT;
+            d_band_top += LCD_BAND_ROWS) {
+        memset(d_buffer, 0, sizeof(d_buffer));
+        draw_scene();
+        uint8_t rows = LCD_HEIGHT - d_band_top;
+        n += stale_rows(d_band_top,
+                rows < LCD_BAND_ROWS ? rows : LCD_BAND_ROWS);
+    }
+    d_band_top = 0;
+    return n;
+#else
+    return stale_rows(0, LCD_HEIGHT);
+#endif
+}
+
+static void write_pbm(const char *dir, const char *name) {
+    char path[256];
+    snprintf(path, sizeof(path), "%s/%s.pbm", dir, name);
+    FILE *f = fopen(path, "wb");
+    if (!f) {
+        perror(path);
+        return;
+    }
+    st7920_write_pbm(f);
+    fclose(f);
+}
+
+// Host nanoseconds per call of fn
+static double time_ns(void (*fn)()) {
+    const long n = 20000;
+    struct timespec start, end;
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    for (long i = 0; i < n; i++) {
+        fn();
+        // Stop the compiler keeping d_buffer in registers across calls
+        __asm__ volatile("" : : "r"(d_buffer) : "memory");
+    }
+    clock_gettime(CLOCK_MONOTONIC, &end);
+    return ((end.tv_sec - start.tv_sec) * 1e9 + (end.tv_nsec - start.tv_nsec))
+            / n;
+}
+
+#if LCD_WIDTH == 128 && LCD_HEIGHT == 64
+//
+// Primitive benchmarks. Each pair draws the same pixels two ways, at fixed
+// places on a 128 by 64 screen.
+
+static void fill_rect_100x40() {
+    display_fill_rect(10, 10, 100, 40);
+}
+
+static void set_rect_100x40() {
+    for (uint8_t y = 10; y < 50; y++) {
+        for (uint8_t x = 10; x < 110; x++) {
+            display_set(x, y);
+        }
+    }
+}
+
+static void hline_128() {
+    display_hline(0, 20, 128);
+}
+
+static void set_hline_128() {
+    for (uint8_t x = 0; x < 128; x++) {
+        display_set(x, 20);
+    }
+}
+
+static void vline_64() {
+    display_vline(70, 0, 64);
+}
+
+static void set_vline_64() {
+    for (uint8_t y = 0; y < 64; y++) {
+        display_set(70, y);
+    }
+}
+
+static void blit_16x16() {
+    display_blit_p(smiley, 37, 21, 16, 16, DISPLAY_OR);
+}
+
+static void set_16x16() {
+    for (uint8_t r = 0; r < 16; r++) {
+        for (uint8_t c = 0; c < 16; c++) {
+            if (pgm_read_byte(&smiley[r * 2 + (c >> 3)]) & (0x80 >> (c & 7))) {
+                display_set(37 + c, 21 + r);
+            }
+        }
+    }
+}
+
+// Eight lines like a frame of demo_lines
+static const uint8_t line_ends[8][4] = {
+    { 33, 0, 58, 1 }, { 10, 5, 120, 40 }, { 0, 63, 127, 0 }, { 5, 2, 20, 60 },
+    { 100, 10, 40, 50 }, { 64, 0, 64, 63 }, { 0, 30, 127, 30 },
+    { 90, 60, 70, 3 },
+};
+
+static void lines_8() {
+    for (uint8_t i = 0; i < 8; i++) {
+        display_line(line_ends[i][0], line_ends[i][1], line_ends[i][2],
+                line_ends[i][3]);
+    }
+}
+
+// The per pixel Bresenham loop display_line replaced
+static void set_line(int x0, int y0, int x1, int y1) {
+    bool steep = abs(y1 - y0) > abs(x1 - x0);
+#define swap(a, b) {int c = a; a = b; b = c;}
+    if (steep) {
+        swap(x0, y0);
+        swap(x1, y1);
+    }
+    if (x0 > x1) {
+        swap(x0, x1);
+        swap(y0, y1);
+    }
+#undef swap
+    int deltax = x1 - x0;
+    int deltay = abs(y1 - y0);
+    int error = deltax >> 1;
+    int ystep = (y0 < y1) ? 1 : -1;
+    int y = y0;
+    for (int x = x0; x <= x1; x++) {
+        if (steep) {
+            display_set(y, x);
+        } else {
+            display_set(x, y);
+        }
+        error = error - deltay;
+        if (error < 0) {
+            y += ystep;
+            error += deltax;
+        }
+    }
+}
+
+static void set_lines_8() {
+    for (uint8_t i = 0; i < 8; i++) {
+        set_line(line_ends[i][0], line_ends[i][1], line_ends[i][2],
+                line_ends[i][3]);
+    }
+}
+
+static void fill_circle_30() {
+    display_fill_circle(64, 32, 30);
+}
+
+static void set_circle_30() {
+    for (int y = -30; y <= 30; y++) {
+        for (int x = -30; x <= 30; x++) {
+            if (x * x + y * y <= 30 * 30 + 30) {
+                display_set_check(64 + x, 32 + y);
+            }
+        }
+    }
+}
+
+typedef struct {
+    const char *name;
+    void (*fast)();
+    void (*slow)();
+} primitive_t;
+
+// A gray ramp across 128 columns, dithered over 64 rows
+static uint8_t ramp[128];
+
+static void bayer_128x64() {
+    dither_t d;
+    dither_begin(&d, DITHER_BAYER, 0, 0, 128, NULL);
+    for (uint8_t y = 0; y < 64; y++) {
+        dither_row(&d, ramp);
+    }
+}
+
+static void set_bayer_128x64() {
+    static const uint8_t bayer[4][4] = {
+        { 8, 136, 40, 168 }, { 200, 72, 232, 104 }, { 56, 184, 24, 152 },
+        { 248, 120, 216, 88 },
+    };
+    display_clear_rect(0, 0, 128, 64);
+    for (uint8_t y = 0; y < 64; y++) {
+        for (uint8_t x = 0; x < 128; x++) {
+            if (ramp[x] < bayer[y & 3][x & 3]) {
+                display_set(x, y);
+            }
+        }
+    }
+}
+
+static int16_t floyd_errors[129];
+
+static void floyd_128x64() {
+    dither_t d;
+    dither_begin(&d, DITHER_FLOYD, 0, 0, 128, floyd_errors);
+    for (uint8_t y = 0; y < 64; y++) {
+        dither_row(&d, ramp);
+    }
+}
+
+// Floyd-Steinberg with an error row and display_set, one pixel at a time
+static void set_floyd_128x64() {
+    int16_t below[130];
+    memset(below, 0, sizeof(below));
+    display_clear_rect(0, 0, 128, 64);
+    for (uint8_t y = 0; y < 64; y++) {
+        int16_t next[130];
+        memset(next, 0, sizeof(next));
+        int16_t right = 0;
+        for (uint8_t x = 0; x < 128; x++) {
+            int16_t v = ramp[x] + below[x + 1] + right;
+            int16_t err = v < 128 ? v : v - 255;
+            if (v < 128) {
+                display_set(x, y);
+            }
+            right = err * 7 / 16;
+            next[x] += err * 3 / 16;
+            next[x + 1] += err * 5 / 16;
+            next[x + 2] += err / 16;
+        }
+        memcpy(below, next, sizeof(below));
+    }
+}
+
+static const primitive_t primitives[] = {
+    { "fill_rect 100x40", fill_rect_100x40, set_rect_100x40 },
+    { "hline 128", hline_128, set_hline_128 },
+    { "vline 64", vline_64, set_vline_64 },
+    { "blit 16x16", blit_16x16, set_16x16 },
+    { "8 lines", lines_8, set_lines_8 },
+    { "fill_circle 30", fill_circle_30, set_circle_30 },
+    { "bayer 128x64", bayer_128x64, set_bayer_128x64 },
+    { "floyd 128x64", floyd_128x64, set_floyd_128x64 },
+};
+
+static void bench_primitives() {
+    printf("\n%-20s %10s %14s %8s\n", "primitive", "ns/call",
+            "display_set ns", "ratio");
+    for (size_t i = 0; i < sizeof(primitives) / sizeof(primitives[0]); i++) {
+        double fast = time_ns(primitives[i].fast);
+        double slow = time_ns(primitives[i].slow);
+        printf("%-20s %10.1f %14.1f %8.1f\n", primitives[i].name, fast, slow,
+                slow / fast);
+    }
+}
+#endif
+
+//
+// Modeled bus time to send d_buffer as data, byte by byte and as a block
+static void bench_transfer() {
+    const uint16_t n = sizeof(d_buffer);
+    printf("\n%-20s %10s %10s %10s\n", "transfer", "bytes", "us/byte",
+            "bytes/s");
+    for (uint8_t block = 0; block < 2; block++) {
+        lcd_instruction(0x36); // extended instructions, graphics on
+        lcd_instruction(0x80); // GDRAM vertical address 0
+        lcd_instruction(0x80); // horizontal address 0
+        st7920_flush();
+        st7920_reset_counters();
+        if (block) {
+            lcd_data_block(d_buffer, n);
+        } else {
+            for (uint16_t i = 0; i < n; i++) {
+                lcd_data(d_buffer[i]);
+            }
+        }
+        st7920_flush();
+        printf("%-20s %10lu %10.2f %10.0f\n",
+                block ? "lcd_data_block" : "lcd_data", st7920.bytes,
+                st7920.us / n, n * 1e6 / st7920.us);
+    }
+}
+
+//
+// RAM taken by the display buffers
+static void report_ram() {
+    size_t total = sizeof(d_buffer) + sizeof(d_dirty);
+    printf("\nRAM: d_buffer %zu + d_dirty %zu", sizeof(d_buffer),
+            sizeof(d_dirty));
+#if LCD_DOUBLE_BUFFER
+    total += sizeof(d_front);
+    printf(" + d_front %zu", sizeof(d_front));
+#endif
+    printf(" = %zu bytes\n", total);
+}
+
+//
+// demo_status's page sent by lcd_text_flush(), and sent whole for each
+// update. The last column counts characters of DDRAM which differ from
+// t_buffer at the end.
+static void bench_text() {
+    printf("\n%-20s %10s %10s %7s\n", "text", "bytes/upd", "us/upd",
+            "stale");
+    for (uint8_t whole = 0; whole < 2; whole++) {
+        lcd_reset();
+        status_setup();
+        lcd_text_flush();
+        st7920_flush();
+        st7920_reset_counters();
+        const uint16_t updates = 120;
+        for (uint16_t t = 0; t < updates; t++) {
+            status_step(t);
+            if (whole) {
+                for (uint8_t line = 0; line < LCD_TEXT_LINES; line++) {
+                    lcd_set_cursor(line, 0);
+                    for (uint8_t col = 0; col < LCD_TEXT_COLS; col++) {
+                        lcd_data(t_buffer[line][col]);
+                    }
+                }
+            } else {
+                lcd_text_flush();
+            }
+        }
+        st7920_flush();
+
+        static const uint8_t starts[] = { 0, 16, 8, 24 };
+        unsigned stale = 0;
+        for (uint8_t line = 0; line < LCD_TEXT_LINES; line++) {
+            for (uint8_t col = 0; col < LCD_TEXT_COLS; col++) {
+                if (st7920.ddram[starts[line] * 2 + col]
+                        != (uint8_t) t_buffer[line][col]) {
+                    stale++;
+                }
+            }
+        }
+        printf("%-20s %10lu %10.1f %7u\n",
+                whole ? "whole screen" : "lcd_text_flush",
+                st7920.bytes / updates, st7920.us / updates, stale);
+        failures += stale;
+    }
+}
+
+#if !LCD_BAND_ROWS
+//
+// demo_scene's dashboard kept up to date by scene_update(), and drawn
+// again from scratch for each frame
+static uint8_t dash_t;
+
+static void dash_retained() {
+    dashboard_step(dash_t++);
+    scene_update();
+}
+
+static void dash_redraw() {
+    dashboard_step(dash_t++);
+    display_clear();
+    scene_draw();
+}
+
+static void bench_scene() {
+    printf("\n%-20s %10s %10s\n", "scene", "bytes/frm", "ns/frame");
+    for (uint8_t redraw = 0; redraw < 2; redraw++) {
+        void (*step)() = redraw ? dash_redraw : dash_retained;
+        lcd_reset();
+        display_clear();
+        display_refresh();
+        dashboard_setup();
+        scene_update();
+        display_refresh_dirty();
+        st7920_flush();
+        st7920_reset_counters();
+        for (dash_t = 0; dash_t < 100;) {
+            step();
+            display_refresh_dirty();
+        }
+        st7920_flush();
+        unsigned long bytes = st7920.bytes / st7920.frames;
+        dash_t = 0;
+        printf("%-20s %10lu %10.1f\n", redraw ? "redraw all" : "scene_update",
+                bytes, time_ns(step));
+    }
+}
+
+//
+// The splash image streamed by lcd_image_p(), and unpacked into d_buffer
+// and sent whole, each with a scroll pending. The last column counts
+// pixels on the display which differ from the image, and display_stats
+// must count the bytes sent.
+static void stream_splash() {
+    lcd_image_p(splash);
+}
+
+static void unpack_splash() {
+    display_image_p(splash, 0, 0);
+    display_refresh();
+}
+
+static void bench_image() {
+    printf("\n%-20s %10s %10s %10s %7s\n", "image", "bytes", "counted", "us",
+            "stale");
+    for (uint8_t unpack = 0; unpack < 2; unpack++) {
+        lcd_reset();
+        display_clear();
+        display_refresh();
+        display_scroll(5);
+        st7920_flush();
+        st7920_reset_counters();
+        memset(&display_stats, 0, sizeof(display_stats));
+        if (unpack) {
+            unpack_splash();
+        } else {
+            stream_splash();
+        }
+        st7920_flush();
+        display_image_p(splash, 0, 0);
+        unsigned stale = stale_pixels();
+        printf("%-20s %10lu %10lu %10.1f %7u\n",
+                unpack ? "display_image_p" : "lcd_image_p", st7920.bytes,
+                (unsigned long) display_stats.sent, st7920.us, stale);
+        failures += stale + (display_stats.sent != st7920.bytes);
+    }
+    printf("%lu bytes packed from %d\n", (unsigned long) sizeof(splash),
+            splash[0] * splash[1]);
+}
+#endif
+
+#if !LCD_BAND_ROWS
+// The handlers of lcd_async.c, which the host has no interrupts to run
+#if LCD_TRANSPORT == LCD_TRANSPORT_USART
+#define TX_vect USART_TX_vect
+#else
+#define TX_vect SPI_STC_vect
+#endif
+void TX_vect(void);
+void TIMER1_COMPA_vect(void);
+void TIMER2_COMPA_vect(void);
+
+//
+// Run the transfer interrupts until the engine is idle, adding the settle
+// time Timer2 is set for after each transfer
+static void pump() {
+    while (display_busy()) {
+        TX_vect();
+        TX_vect();
+        TX_vect();
+        double prescale = TCCR2B == _BV(CS21) ? 8.0 : 256.0;
+        host_delay_us((OCR2A + 1) * prescale / (F_CPU / 1000000UL));
+        TIMER2_COMPA_vect();
+    }
+    st7920_flush();
+}
+
+//
+// demo_scroll's log sent by display_refresh_async() and then
+// display_refresh_dirty_async(), with the interrupts run by pump(), and
+// a clear queued in text mode, which should wait as long as lcd_clear().
+// display_stats must count the bytes which went out.
+static void bench_async() {
+    char buf[7];
+
+    printf("\n%-20s %10s %10s %10s %7s %7s\n", "async", "bytes", "counted",
+            "us", "errors", "stale");
+    lcd_reset();
+    st7920_reset_counters();
+    memset(&display_stats, 0, sizeof(display_stats));
+    display_clear();
+    display_text_p(&font_small, 2, 0, PSTR("Async"), DISPLAY_OR);
+    display_refresh_async();
+    pump();
+    unsigned stale = stale_pixels();
+    printf("%-20s %10lu %10lu %10.1f %7lu %7u\n", "refresh_async",
+            st7920.bytes, (unsigned long) display_stats.sent, st7920.us,
+            st7920.errors, stale);
+    failures += st7920.errors + stale + (display_stats.sent != st7920.bytes)
+            + (display_stats.naive != LCD_NAIVE_BYTES);
+
+    st7920_reset_counters();
+    memset(&display_stats, 0, sizeof(display_stats));
+    stale = 0;
+    for (int t = 0; t < 40; t++) {
+        display_scroll(9);
+        int x = display_text_p(&font_small, 2, LCD_HEIGHT - 9,
+                PSTR("Log line "), DISPLAY_OR);
+        display_text(&font_small, x, LCD_HEIGHT - 9, itoa(t, buf, 10),
+                DISPLAY_OR);
+        display_refresh_dirty_async();
+        pump();
+        stale += stale_pixels();
+    }
+    printf("%-20s %10lu %10lu %10.1f %7lu %7u\n", "refresh_dirty_async",
+            st7920.bytes / 40, (unsigned long) display_stats.sent / 40,
+            st7920.us / 40, st7920.errors, stale);
+    failures += st7920.errors + stale + (display_stats.sent != st7920.bytes)
+            + (display_stats.naive != 40UL * LCD_NAIVE_BYTES);
+
+    lcd_reset();
+    st7920_reset_counters();
+    lcd_queue_instruction(0b00000001); // clear
+    pump();
+    printf("%-20s %10lu %10s %10.1f %7lu %7s\n", "queued clear",
+            st7920.bytes, "-", st7920.us, st7920.errors, "-");
+    failures += st7920.errors + (st7920.us < LCD_CLEAR_US);
+}
+#endif
+
+#if LCD_GRAY_ROWS
+//
+// Pixels of the display which differ from what should be showing: the
+// plane last sent in the gray rows, and d_buffer below them
+static unsigned stale_gray(uint8_t plane) {
+    unsigned n = 0;
+    for (uint8_t y = 0; y < LCD_HEIGHT; y++) {
+        const uint8_t *row = (plane && y < LCD_GRAY_ROWS ? d_gray : d_buffer)
+                + y * LCD_ROW_BYTES;
+        for (unsigned x = 0; x < LCD_WIDTH; x++) {
+            bool set = row[x >> 3] & (0x80 >> (x & 7));
+            if (set != st7920_pixel(x, y)) {
+                n++;
+            }
+        }
+    }
+    return n;
+}
+
+static void bench_gray() {
+    lcd_reset();
+    gray_setup();
+    display_gray_start(GRAY_HZ);
+    pump();
+    st7920_reset_counters();
+
+    // Ending on a tick sending d_buffer, as explained below
+    const uint8_t ticks = 121;
+    unsigned stale = 0;
+    for (uint8_t t = 0; t < ticks; t++) {
+        gray_step(t);
+        TIMER1_COMPA_vect();
+        pump();
+        stale += stale_gray(t % 3 == 2);
+    }
+    display_gray_counters_t c;
+    display_gray_counters(&c);
+    // The last tick sent d_buffer, so stopping sends nothing
+    display_gray_stop();
+
+    double us = st7920.us / ticks;
+    printf("\n%-20s %10s %10s %10s %7s\n", "gray", "bytes/tick", "us/tick",
+            "max hz", "stale");
+    printf("%-20s %10lu %10.1f %10.1f %7u\n", "display_gray_start",
+            st7920.bytes / ticks, us, 1000000.0 / us, stale);
+    failures += stale;
+    printf("%u planes in %u ticks, bus busy %.1f%% at %d hz\n", c.frames,
+            c.ticks, c.bus_us * 100.0 / (c.ticks * 1000000.0 / GRAY_HZ),
+            GRAY_HZ);
+}
+#endif
+
+#if LCD_BAND_ROWS
+// Drawing done by display_render(), without sending anything
+static void draw_bands() {
+    for (d_band_top = 0; d_band_top < LCD_HEIGHT;
+            d_band_top += LCD_BAND_ROWS) {
+        memset(d_buffer, 0, sizeof(d_buffer));
+        draw_scene();
+    }
+    d_band_top = 0;
+}
+
+static void bench_bands() {
+    scene_t = 30;
+    printf("%d bands of %d rows: %.1f ns to draw a frame\n",
+            (LCD_HEIGHT + LCD_BAND_ROWS - 1) / LCD_BAND_ROWS, LCD_BAND_ROWS,
+            time_ns(draw_bands));
+}
+#endif
+
+int main(int argc, char **argv) {
+    const char *pbm_dir = NULL;
+    if (argc == 3 && !strcmp(argv[1], "-p")) {
+        pbm_dir = argv[2];
+    } else if (argc != 1) {
+        fprintf(stderr, "usage: %s [-p dir]\n", argv[0]);
+        return 2;
+    }
+
+    st7920_reset();
+    spi_init();
+    lcd_reset();
+
+    printf("%-14s %7s %10s %10s %10s %10s %7s %7s\n", "demo", "frames",
+            "bytes", "bytes/frm", "naive/frm", "ms/frame", "errors", "stale");
+    for (size_t i = 0; i < sizeof(demos) / sizeof(demos[0]); i++) {
+        lcd_reset();
+        st7920_reset_counters();
+        memset(&display_stats, 0, sizeof(display_stats));
+        demos[i].run();
+        st7920_flush();
+
+        unsigned long frames = st7920.frames ? st7920.frames : 1;
+        unsigned stale = stale_pixels();
+        printf("%-14s %7lu %10lu %10lu %10lu %10.2f %7lu %7u\n",
+                demos[i].name, st7920.frames, st7920.bytes,
+                st7920.bytes / frames,
+                (unsigned long) display_stats.naive / frames,
+                st7920.us / 1000.0 / frames, st7920.errors, stale);
+        failures += st7920.errors + stale;
+        if (pbm_dir) {
+            write_pbm(pbm_dir, demos[i].name);
+        }
+    }
+
+    report_ram();
+#if LCD_BAND_ROWS
+    bench_bands();
+#endif
+    bench_text();
+#if !LCD_BAND_ROWS
+    bench_scene();
+    bench_image();
+    bench_async();
+#endif
+#if LCD_GRAY_ROWS
+    bench_gray();
+#endif
+    bench_transfer();
+#if LCD_WIDTH == 128 && LCD_HEIGHT == 64
+    for (uint8_t x = 0; x < 128; x++) {
+        ramp[x] = x * 2;
+    }
+    bench_primitives();
+#endif
+    if (failures) {
+        printf("\n%lu stale or malformed\n", failures);
+        return 1;
+    }
+    return 0;
+}
@@ -0,0 +1,143 @@
+/*
+ * glyph_check.c
+ *
+ * Randomized check of the CGRAM glyph cache in lcd_glyph.c against the
+ * host ST7920 emulator. Glyphs are asked for at random from sets of 4 and
+ * of 10, and after each request:
+ *
+ *   - the code returned must show the glyph asked for in emulated CGRAM
+ *   - a glyph already cached must cost no bytes on the bus
+ *   - a glyph not cached must go in an empty slot, or else replace the
+ *     least recently asked for, as worked out here from when each slot
+ *     was last used
+ *
+ * A fixed sequence of 6 glyphs checks the eviction order step by step.
+ *
+ * Build and run from the top of the repository:
+ *
+ *   gcc -std=gnu99 -O2 -DF_CPU=16000000UL -Ilcdhost -Ilcdlib \
+ *       -o glyph_check lcdhost/avr_host.c lcdhost/st7920.c \
+ *       lcdhost/glyph_check.c lcdlib/lcd_*.c
+ *   ./glyph_check [requests [seed]]
+ *
+ * The exit status is 1 if any request went wrong.
+ */
+
+#include <avr/io.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "lcd.h"
+#include "st7920.h"
+
+#define SLOTS 4
+#define GLYPHS 10
+
+static uint8_t glyphs[GLYPHS][32];
+
+// The expected cache: glyph in each slot or -1, and when each slot was
+// last used
+static int8_t held[SLOTS];
+static long used[SLOTS];
+static long now;
+
+static unsigned long failures;
+
+static void reset() {
+    lcd_reset();
+    lcd_glyph_reset();
+    for (uint8_t s = 0; s < SLOTS; s++) {
+        held[s] = -1;
+        used[s] = -1;
+    }
+    now = 0;
+}
+
+//
+// Ask for glyph g, and check the result against the expected cache.
+// Returns the slot used.
+static uint8_t request(uint8_t g) {
+    unsigned long before = st7920.bytes;
+    uint8_t code = lcd_glyph_p(glyphs[g]);
+    st7920_flush();
+    bool sent = st7920.bytes != before;
+
+    int8_t slot = -1;
+    for (uint8_t s = 0; s < SLOTS; s++) {
+        if (held[s] == g) {
+            slot = s;
+        }
+    }
+    bool hit = slot >= 0;
+    if (!hit) {
+        slot = 0;
+        for (uint8_t s = 1; s < SLOTS; s++) {
+            if (used[s] < used[slot]) {
+                slot = s;
+            }
+        }
+        // Which of several empty slots is taken is up to the cache
+        if (held[slot] < 0 && code / 2 < SLOTS && held[code / 2] < 0) {
+            slot = code / 2;
+        }
+        held[slot] = g;
+    }
+    used[slot] = now++;
+    if (code != slot * 2 || sent == hit
+            || memcmp(st7920.cgram + code * 16, glyphs[g], 32)) {
+        if (!failures) {
+            printf("glyph %u: code %u, expected %u, %s\n", g, code,
+                    slot * 2, sent ? "loaded" : "not loaded");
+        }
+        failures++;
+    }
+    return slot;
+}
+
+//
+// Ask for glyphs at random from the first n
+static void random_requests(uint8_t n, unsigned long requests) {
+    reset();
+    unsigned long hits = 0;
+    for (unsigned long r = 0; r < requests; r++) {
+        unsigned long before = st7920.bytes;
+        request(rand() % n);
+        hits += st7920.bytes == before;
+    }
+    printf("%2u glyphs: %lu requests, %lu hits\n", n, requests, hits);
+}
+
+int main(int argc, char **argv) {
+    unsigned long requests = argc > 1 ? strtoul(argv[1], NULL, 0) : 10000;
+    srand(argc > 2 ? strtoul(argv[2], NULL, 0) : 1);
+    for (uint8_t g = 0; g < GLYPHS; g++) {
+        for (uint8_t i = 0; i < 32; i++) {
+            glyphs[g][i] = rand();
+        }
+    }
+
+    st7920_reset();
+    spi_init();
+
+    // A to D fill the four slots, E replaces A, and after B is used
+    // again F replaces C, the least recently used. B and D stay put.
+    reset();
+    uint8_t a = request(0), b = request(1), c = request(2), d = request(3);
+    uint8_t e = request(4);
+    uint8_t b2 = request(1);
+    uint8_t f = request(5);
+    uint8_t d2 = request(3);
+    bool order = !failures && (1 << a | 1 << b | 1 << c | 1 << d) == 0x0f
+            && e == a && b2 == b && f == c && d2 == d;
+    if (!order) {
+        failures++;
+    }
+    printf("eviction order %s\n", order ? "ok" : "wrong");
+
+    random_requests(4, requests);
+    random_requests(GLYPHS, requests);
+    printf("%lu requests wrong, %lu protocol errors\n", failures,
+            st7920.errors);
+    return failures || st7920.errors;
+}
@@ -0,0 +1,170 @@
+/*
+ * imgconv.c
+ *
+ * Converts a PBM file into a C header holding it as a PackBits packed
+ * image for display_image_p() and lcd_image_p(). Set pixels in the PBM
+ * are set on the display. Other formats can be made into PBM first, for
+ * example with ImageMagick:
+ *
+ *   convert splash.png -dither FloydSteinberg -monochrome splash.pbm
+ *
+ * Build and run from the top of the repository:
+ *
+ *   gcc -std=gnu99 -O2 -o imgconv lcdhost/imgconv.c
+ *   ./imgconv name image.pbm > image.h
+ *
+ * The header declares a static array called name.
+ */
+
+#include <ctype.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+// Largest image an lcdlib image can hold
+#define MAX_STRIDE 32
+#define MAX_ROWS 255
+
+//
+// Next number in a PBM header, skipping white space and comments.
+// Returns -1 if there isn't one.
+static int read_number(FILE *f) {
+    int c = fgetc(f);
+    while (c == '#' || isspace(c)) {
+        if (c == '#') {
+            while (c != '\n' && c != EOF) {
+                c = fgetc(f);
+            }
+        }
+        c = fgetc(f);
+    }
+    if (!isdigit(c)) {
+        return -1;
+    }
+    int n = 0;
+    while (isdigit(c)) {
+        n = n * 10 + c - '0';
+        c = fgetc(f);
+    }
+    return n;
+}
+
+//
+// Read a P1 or P4 PBM into rows of stride bytes, leftmost pixel in the top
+// bit. Returns NULL with a message on stderr if it can't.
+static uint8_t *read_pbm(FILE *f, int *w, int *h) {
+    char magic[2];
+    if (fread(magic, 1, 2, f) != 2 || magic[0] != 'P'
+            || (magic[1] != '1' && magic[1] != '4')) {
+        fprintf(stderr, "not a PBM file\n");
+        return NULL;
+    }
+    *w = read_number(f);
+    *h = read_number(f);
+    if (*w <= 0 || *h <= 0) {
+        fprintf(stderr, "bad PBM header\n");
+        return NULL;
+    }
+    int stride = (*w + 7) / 8;
+    if (stride > MAX_STRIDE || *h > MAX_ROWS) {
+        fprintf(stderr, "%dx%d is too big, most is %dx%d\n", *w, *h,
+                MAX_STRIDE * 8, MAX_ROWS);
+        return NULL;
+    }
+
+    uint8_t *data = calloc(stride, *h);
+    if (magic[1] == '4') {
+        // One white space character ended the height
+        if (fread(data, stride, *h, f) != (size_t) *h) {
+            fprintf(stderr, "PBM file is short\n");
+            free(data);
+            return NULL;
+        }
+        return data;
+    }
+    for (int y = 0; y < *h; y++) {
+        for (int x = 0; x < *w; x++) {
+            int c;
+            do {
+                c = fgetc(f);
+            } while (isspace(c));
+            if (c != '0' && c != '1') {
+                fprintf(stderr, "PBM file is short\n");
+                free(data);
+                return NULL;
+            }
+            if (c == '1') {
+                data[y * stride + x / 8] |= 0x80 >> (x & 7);
+            }
+        }
+    }
+    return data;
+}
+
+//
+// PackBits n bytes into out, which has room for n + n / 128 + 1 bytes.
+// Returns the packed length.
+static size_t pack(const uint8_t *in, size_t n, uint8_t *out) {
+    size_t i = 0, o = 0;
+    while (i < n) {
+        size_t run = 1;
+        while (i + run < n && run < 128 && in[i + run] == in[i]) {
+            run++;
+        }
+        if (run >= 2) {
+            out[o++] = 257 - run;
+            out[o++] = in[i];
+            i += run;
+            continue;
+        }
+        // Copy bytes as they are up to a run of three, which is worth
+        // breaking off for
+        size_t j = i + 1;
+        while (j < n && j - i < 128
+                && !(j + 2 < n && in[j] == in[j + 1] && in[j] == in[j + 2])) {
+            j++;
+        }
+        out[o++] = j - i - 1;
+        memcpy(out + o, in + i, j - i);
+        o += j - i;
+        i = j;
+    }
+    return o;
+}
+
+int main(int argc, char **argv) {
+    if (argc != 3) {
+        fprintf(stderr, "usage: %s name image.pbm\n", argv[0]);
+        return 2;
+    }
+    FILE *f = fopen(argv[2], "rb");
+    if (!f) {
+        perror(argv[2]);
+        return 1;
+    }
+    int w, h;
+    uint8_t *data = read_pbm(f, &w, &h);
+    fclose(f);
+    if (!data) {
+        return 1;
+    }
+
+    size_t n = (size_t) (w + 7) / 8 * h;
+    uint8_t *packed = malloc(n + n / 128 + 1);
+    size_t len = pack(data, n, packed);
+
+    const char *base = strrchr(argv[2], '/');
+    printf("// %s: %dx%d, %zu bytes packed into %zu. Made by imgconv.\n",
+            base ? base + 1 : argv[2], w, h, n, len + 2);
+    printf("static const uint8_t %s[] PROGMEM = {\n", argv[1]);
+    printf("    %d, %d,", (w + 7) / 8, h);
+    for (size_t i = 0; i < len; i++) {
+        printf(i % 12 ? " 0x%02x," : "\n    0x%02x,", packed[i]);
+    }
+    printf("\n};\n");
+
+    free(packed);
+    free(data);
+    return 0;
+}
@@ -0,0 +1,114 @@
+/*
+ * print_check.cpp
+ *
+ * Check of LcdPrint, in lcd_print.h, against the host ST7920 emulator,
+ * using the stand in Print.h. Each case prints through LcdPrint, flushes,
+ * and compares both t_buffer and the emulated DDRAM with the four lines
+ * expected: wrapping at the end of a line and from the last line to the
+ * first, a full line ended by println(), '\n' blanking the rest of a line
+ * and '\r' being ignored.
+ *
+ * Build and run from the top of the repository:
+ *
+ *   gcc -std=gnu99 -O2 -DF_CPU=16000000UL -Ilcdhost -Ilcdlib -c \
+ *       lcdhost/avr_host.c lcdhost/st7920.c lcdlib/lcd_*.c
+ *   g++ -O2 -DF_CPU=16000000UL -Ilcdhost -Ilcdlib -o print_check \
+ *       lcdhost/print_check.cpp *.o
+ *   ./print_check
+ *
+ * The exit status is 1 if any case fails.
+ */
+
+#include <stdio.h>
+#include <string.h>
+
+#include "lcd.h"
+#include "lcd_print.h"
+
+extern "C" {
+#include "st7920.h"
+}
+
+static LcdPrint lcd;
+static unsigned failures;
+
+//
+// Flush, then compare t_buffer and DDRAM with the expected lines, which
+// are padded with spaces
+static void expect(const char *name, const char *lines[LCD_TEXT_LINES]) {
+    static const uint8_t starts[] = { 0, 16, 8, 24 };
+    lcd.flush();
+    st7920_flush();
+    bool ok = true;
+    for (uint8_t line = 0; line < LCD_TEXT_LINES; line++) {
+        char want[LCD_TEXT_COLS];
+        memset(want, ' ', sizeof(want));
+        memcpy(want, lines[line], strlen(lines[line]));
+        for (uint8_t col = 0; col < LCD_TEXT_COLS; col++) {
+            if (t_buffer[line][col] != want[col]
+                    || st7920.ddram[starts[line] * 2 + col] != want[col]) {
+                ok = false;
+            }
+        }
+    }
+    printf("%-20s %s\n", name, ok ? "ok" : "FAILED");
+    if (!ok) {
+        st7920_write_text(stdout);
+        failures++;
+    }
+}
+
+int main() {
+    st7920_reset();
+    spi_init();
+    lcd_reset();
+    lcd.begin();
+
+    lcd.println("0123456789abcdef");
+    lcd.println("ab");
+    const char *full_line[] = { "0123456789abcdef", "ab", "", "" };
+    expect("full line println", full_line);
+
+    lcd.clear();
+    lcd.print("0123456789abcdefWXYZ");
+    const char *wrap[] = { "0123456789abcdef", "WXYZ", "", "" };
+    expect("wrap", wrap);
+
+    lcd.clear();
+    lcd.setCursor(3, 0);
+    lcd.print("0123456789abcdef");
+    lcd.print("Q");
+    const char *wrap_last[] = { "Q", "", "", "0123456789abcdef" };
+    expect("wrap last line", wrap_last);
+
+    lcd.clear();
+    lcd.print("0123456789abcdef\rZ");
+    const char *wrap_cr[] = { "0123456789abcdef", "Z", "", "" };
+    expect("wrap after \\r", wrap_cr);
+
+    lcd.clear();
+    lcd.print("xxxxxxxxxx");
+    lcd.setCursor(0, 2);
+    lcd.print("a\rb\n");
+    lcd.print("c");
+    const char *newline[] = { "xxab", "c", "", "" };
+    expect("\\n and \\r", newline);
+
+    lcd.clear();
+    lcd.print(12);
+    lcd.print(": ");
+    lcd.println(345);
+    lcd.println(-6);
+    const char *numbers[] = { "12: 345", "-6", "", "" };
+    expect("numbers", numbers);
+
+    lcd.clear();
+    for (uint8_t i = 0; i < 5; i++) {
+        lcd.println(i);
+    }
+    const char *lines[] = { "4", "1", "2", "3" };
+    expect("println wraps", lines);
+
+    printf("%lu protocol errors\n", st7920.errors);
+    return failures || st7920.errors;
+}
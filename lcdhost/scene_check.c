@@ -0,0 +1,173 @@
+/*
+ * scene_check.c
+ *
+ * Randomized check of the retained scene in lcd_scene.c. Items are added,
+ * moved, changed and removed at random, partly or wholly off the screen,
+ * and after each round scene_update() and display_refresh_dirty() bring
+ * the emulated display up to date. The display must then match
+ * scene_draw() on a cleared d_buffer, so every word scene_update() changed
+ * must have been marked dirty.
+ *
+ * Build and run from the top of the repository:
+ *
+ *   gcc -std=gnu99 -O2 -DF_CPU=16000000UL -Ilcdhost -Ilcdlib \
+ *       -o scene_check lcdhost/avr_host.c lcdhost/st7920.c \
+ *       lcdhost/scene_check.c lcdlib/lcd_*.c
+ *   ./scene_check [rounds [seed]]
+ *
+ * Set LCD_WIDTH and LCD_HEIGHT to check another panel size. The exit
+ * status is 1 if any round left the display wrong.
+ */
+
+#include <avr/io.h>
+#include <avr/pgmspace.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "lcd.h"
+#include "st7920.h"
+
+#if LCD_BAND_ROWS
+#error "scene_update() needs the whole screen in d_buffer"
+#endif
+
+static const uint8_t box[] PROGMEM = {
+    0xff, 0x81, 0xa5, 0x81, 0x81, 0xbd, 0x81, 0xff,
+};
+
+// Strings of the text items, which stay in place while in the scene
+static char strings[LCD_SCENE_ITEMS][8];
+
+// Items in the scene, and for text items the string each uses
+static uint8_t ids[LCD_SCENE_ITEMS];
+static int8_t string_of[LCD_SCENE_ITEMS];
+static uint8_t count;
+
+static int coord(int size) {
+    return rand() % (size + 40) - 20;
+}
+
+static void random_string(char *s) {
+    uint8_t n = rand() % 7;
+    for (uint8_t i = 0; i < n; i++) {
+        s[i] = ' ' + rand() % 95;
+    }
+    s[n] = 0;
+}
+
+static void add() {
+    uint8_t id;
+    int8_t str = -1;
+    switch (rand() % 5) {
+    case 0:
+        id = scene_line(coord(LCD_WIDTH), coord(LCD_HEIGHT),
+                coord(LCD_WIDTH), coord(LCD_HEIGHT));
+        break;
+    case 1:
+        id = scene_circle(coord(LCD_WIDTH), coord(LCD_HEIGHT), rand() % 30);
+        break;
+    case 2:
+        id = scene_rect(coord(LCD_WIDTH), coord(LCD_HEIGHT),
+                rand() % (LCD_WIDTH + 1), rand() % 20);
+        break;
+    case 3:
+        // A free string, as removed items' strings are let go
+        for (str = 0; str < LCD_SCENE_ITEMS; str++) {
+            bool used = false;
+            for (uint8_t i = 0; i < count; i++) {
+                used |= string_of[i] == str;
+            }
+            if (!used) {
+                break;
+            }
+        }
+        random_string(strings[str]);
+        id = scene_text(&font_small, coord(LCD_WIDTH), coord(LCD_HEIGHT),
+                strings[str]);
+        break;
+    default:
+        id = scene_bitmap_p(box, coord(LCD_WIDTH), coord(LCD_HEIGHT), 8, 8);
+        break;
+    }
+    if (id != SCENE_NONE) {
+        ids[count] = id;
+        string_of[count] = str;
+        count++;
+    }
+}
+
+static void step() {
+    uint8_t op = rand() % 4;
+    if (!count || (op == 0 && count < LCD_SCENE_ITEMS)) {
+        add();
+        return;
+    }
+    uint8_t i = rand() % count;
+    if (op == 1) {
+        scene_move(ids[i], rand() % 21 - 10, rand() % 21 - 10);
+    } else if (op == 2 && string_of[i] >= 0) {
+        random_string(strings[string_of[i]]);
+        scene_changed(ids[i]);
+    } else {
+        scene_remove(ids[i]);
+        count--;
+        ids[i] = ids[count];
+        string_of[i] = string_of[count];
+    }
+}
+
+//
+// Pixels on the display which differ from the whole scene drawn afresh.
+// Leaves d_buffer as it was, with nothing dirty.
+static unsigned check() {
+    static uint8_t kept[LCD_BUFFER_SIZE];
+    memcpy(kept, d_buffer, sizeof(kept));
+    display_clear();
+    scene_draw();
+    unsigned n = 0;
+    for (uint8_t y = 0; y < LCD_HEIGHT; y++) {
+        for (unsigned x = 0; x < LCD_WIDTH; x++) {
+            bool set = d_buffer[y * LCD_ROW_BYTES + (x >> 3)]
+                    & (0x80 >> (x & 7));
+            if (set != st7920_pixel(x, y)) {
+                n++;
+            }
+        }
+    }
+    memcpy(d_buffer, kept, sizeof(kept));
+    memset(d_dirty, 0, sizeof(d_dirty));
+    return n;
+}
+
+int main(int argc, char **argv) {
+    unsigned long rounds = argc > 1 ? strtoul(argv[1], NULL, 0) : 5000;
+    srand(argc > 2 ? strtoul(argv[2], NULL, 0) : 1);
+
+    st7920_reset();
+    spi_init();
+    lcd_reset();
+    display_clear();
+    display_refresh();
+
+    unsigned long bad = 0;
+    for (unsigned long r = 0; r < rounds; r++) {
+        for (uint8_t n = rand() % 4; n; n--) {
+            step();
+        }
+        if (rand() % 500 == 0) {
+            scene_clear();
+            count = 0;
+        }
+        scene_update();
+        display_refresh_dirty();
+        st7920_flush();
+        unsigned stale = check();
+        if (stale && !bad++) {
+            printf("round %lu: %u pixels differ\n", r, stale);
+        }
+    }
+    printf("%dx%d: %lu of %lu rounds wrong, %lu protocol errors\n",
+            LCD_WIDTH, LCD_HEIGHT, bad, rounds, st7920.errors);
+    return bad || st7920.errors;
+}
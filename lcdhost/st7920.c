@@ -0,0 +1,194 @@
+/*
+ * st7920.c
+ *
+ * Host side emulation of an ST7920. See st7920.h.
+ */
+
+#include <string.h>
+
+#include "lcd.h"
+#include "st7920.h"
+
+st7920_t st7920;
+
+// Fosc / 2 at 16MHz, as set up by spi_init()
+double st7920_spi_mhz = 8.0;
+
+void st7920_reset() {
+    memset(&st7920, 0, sizeof(st7920));
+    memset(st7920.ddram, ' ', sizeof(st7920.ddram));
+}
+
+void st7920_reset_counters() {
+    st7920.bytes = 0;
+    st7920.instructions = 0;
+    st7920.data = 0;
+    st7920.frames = 0;
+    st7920.errors = 0;
+    st7920.us = 0;
+}
+
+static void _basic_instruction(uint8_t ins) {
+    if (ins & 0x80) {
+        // Set DDRAM address
+        st7920.ac = ins & 0x1f;
+        st7920.cgram_selected = false;
+        st7920.low_byte = false;
+    } else if (ins & 0x40) {
+        // Set CGRAM address
+        st7920.ac = ins & 0x3f;
+        st7920.cgram_selected = true;
+        st7920.low_byte = false;
+    } else if (ins == 0x01) {
+        // Clear
+        memset(st7920.ddram, ' ', sizeof(st7920.ddram));
+        st7920.ac = 0;
+        st7920.cgram_selected = false;
+        st7920.low_byte = false;
+    } else if ((ins & 0xfe) == 0x02) {
+        // Home
+        st7920.ac = 0;
+        st7920.cgram_selected = false;
+        st7920.low_byte = false;
+    }
+    // Entry mode, display control and shift don't affect the model
+}
+
+static void _extended_instruction(uint8_t ins) {
+    if (ins & 0x80) {
+        // Set GDRAM address, vertical then horizontal
+        if (st7920.gd_need_word) {
+            st7920.gd_word = ins & 0x0f;
+            st7920.gd_need_word = false;
+        } else {
+            st7920.gd_row = ins & 0x3f;
+            st7920.gd_need_word = true;
+        }
+        st7920.low_byte = false;
+    } else if (ins & 0x40) {
+        // Set scroll address, or IRAM address when SR is clear
+        if (st7920.scroll_select) {
+            st7920.scroll = ins & 0x3f;
+        }
+    } else if ((ins & 0xfe) == 0x02) {
+        // Scroll or RAM address select
+        st7920.scroll_select = ins & 0x01;
+    }
+    // Standby, reverse and sleep don't affect the model
+}
+
+static void _instruction(uint8_t ins) {
+    st7920.instructions++;
+    if ((ins & 0xe0) == 0x20) {
+        // Function set, common to both instruction sets
+        st7920.extended = ins & 0x04;
+        if (st7920.extended) {
+            bool graphics = ins & 0x02;
+            if (graphics && !st7920.graphics) {
+                st7920.frames++;
+            }
+            st7920.graphics = graphics;
+        }
+        st7920.gd_need_word = false;
+        return;
+    }
+    if (st7920.extended) {
+        _extended_instruction(ins);
+    } else {
+        _basic_instruction(ins);
+    }
+}
+
+static void _data(uint8_t b) {
+    st7920.data++;
+    if (st7920.extended) {
+        st7920.gdram[st7920.gd_row][st7920.gd_word * 2 + st7920.low_byte] = b;
+        if (st7920.low_byte) {
+            st7920.gd_word = (st7920.gd_word + 1) & 0x0f;
+        }
+    } else if (st7920.cgram_selected) {
+        st7920.cgram[st7920.ac * 2 + st7920.low_byte] = b;
+        if (st7920.low_byte) {
+            st7920.ac = (st7920.ac + 1) & 0x3f;
+        }
+    } else {
+        st7920.ddram[st7920.ac * 2 + st7920.low_byte] = b;
+        if (st7920.low_byte) {
+            st7920.ac = (st7920.ac + 1) & 0x1f;
+        }
+    }
+    st7920.low_byte = !st7920.low_byte;
+}
+
+void st7920_receive(uint8_t b) {
+    st7920.bytes++;
+    st7920.us += 8.0 / st7920_spi_mhz;
+
+    // A byte with any of its low bits set can only be a sync byte. Any
+    // number of nibble pairs may follow one sync.
+    if (st7920.nbytes == 0 || (b & 0x0f)) {
+        if ((b & 0xf9) != 0xf8) {
+            // Not a sync byte. The controller would lose step.
+            st7920.errors++;
+            st7920.nbytes = 0;
+            return;
+        }
+        if (st7920.nbytes == 2) {
+            // Sync in the middle of a nibble pair
+            st7920.errors++;
+        }
+        st7920.sync = b;
+        st7920.nbytes = 1;
+        return;
+    }
+    if (st7920.nbytes == 1) {
+        st7920.high = b & 0xf0;
+        st7920.nbytes = 2;
+        return;
+    }
+    st7920.nbytes = 1;
+
+    uint8_t v = st7920.high | (b >> 4);
+    if (st7920.sync & 0x04) {
+        // RW = 1. Reads aren't possible on the serial interface.
+        st7920.errors++;
+    } else if (st7920.sync & 0x02) {
+        _data(v);
+    } else {
+        _instruction(v);
+    }
+}
+
+bool st7920_pixel(uint8_t x, uint8_t y) {
+    uint8_t line = y % LCD_GDRAM_LINES;
+    uint8_t row = (line + st7920.scroll) & 0x3f;
+    uint8_t byte = (y < LCD_GDRAM_LINES ? 0 : LCD_ROW_BYTES) + (x >> 3);
+    return st7920.gdram[row][byte] & (0x80 >> (x & 7));
+}
+
+void st7920_write_pbm(FILE *f) {
+    fprintf(f, "P4\n%d %d\n", LCD_WIDTH, LCD_HEIGHT);
+    for (uint8_t y = 0; y < LCD_HEIGHT; y++) {
+        for (unsigned x = 0; x < LCD_WIDTH; x += 8) {
+            uint8_t b = 0;
+            for (uint8_t i = 0; i < 8; i++) {
+                if (st7920_pixel(x + i, y)) {
+                    b |= 0x80 >> i;
+                }
+            }
+            fputc(b, f);
+        }
+    }
+}
+
+void st7920_write_text(FILE *f) {
+    // Lines 0, 1, 2 and 3 start at addresses 0, 16, 8 and 24
+    static const uint8_t starts[] = { 0, 16, 8, 24 };
+    for (uint8_t line = 0; line < 4; line++) {
+        const uint8_t *p = st7920.ddram + starts[line] * 2;
+        for (uint8_t i = 0; i < 16; i++) {
+            fputc(p[i] >= ' ' && p[i] < 0x7f ? p[i] : '.', f);
+        }
+        fputc('\n', f);
+    }
+}
@@ -0,0 +1,88 @@
+/*
+ * st7920.h
+ *
+ * Host side emulation of an ST7920 on a 12864ZB module, driven through the
+ * serial interface.
+ *
+ * Bytes written to SPDR are decoded as the serial protocol: a sync byte of
+ * five 1 bits, RW, RS and 0, then two bytes carrying the high and low
+ * nibbles in their top four bits. More pairs may follow the same sync
+ * byte, each being another transfer of the same kind. Decoded instructions
+ * and data update the emulated DDRAM, CGRAM and GDRAM just as the
+ * controller would.
+ *
+ * Alongside the controller state this keeps a model of the time spent on
+ * the bus: one SPI byte time per byte sent plus every _delay_us/_delay_ms.
+ */
+
+#ifndef ST7920_H_
+#define ST7920_H_
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+
+typedef struct {
+    // Basic instructions: DDRAM holds 32 two byte character cells,
+    // CGRAM holds 4 glyphs of 16 rows of 16 bits.
+    uint8_t ddram[64];
+    uint8_t cgram[128];
+
+    // Extended instructions: GDRAM is 64 rows of 16 words. On a 128 by 64
+    // panel the top of the screen is words 0-7 of rows 0-31 and the bottom
+    // is words 8-15. See LCD_GDRAM_FOLD in lcd.h.
+    uint8_t gdram[64][32];
+
+    bool extended; // RE, extended instruction set
+    bool graphics; // G, graphics display on
+    bool scroll_select; // SR, 0x40 sets the vertical scroll address
+    uint8_t scroll; // vertical scroll address
+    uint8_t ac; // address counter for DDRAM and CGRAM, in two byte units
+    bool cgram_selected; // data goes to CGRAM rather than DDRAM
+    bool low_byte; // next data byte is the second of a pair
+    uint8_t gd_row; // GDRAM vertical address
+    uint8_t gd_word; // GDRAM horizontal address
+    bool gd_need_word; // next address instruction is the horizontal one
+
+    // Serial decoder
+    uint8_t sync; // sync byte of the transfer being received
+    uint8_t nbytes; // bytes received of the current transfer
+    uint8_t high; // high nibble
+
+    // Counters
+    unsigned long bytes; // bytes on the wire
+    unsigned long instructions;
+    unsigned long data;
+    unsigned long frames; // graphics mode entries, once per refresh
+    unsigned long errors; // malformed transfers and reads
+    double us; // modeled bus time
+} st7920_t;
+
+extern st7920_t st7920;
+
+// SPI bit rate used for the time model, in bits per microsecond
+extern double st7920_spi_mhz;
+
+// Power on state, with counters zeroed
+void st7920_reset();
+
+// Zero the counters only
+void st7920_reset_counters();
+
+// Take one byte from the serial line
+void st7920_receive(uint8_t b);
+
+// Deliver any byte still sitting in SPDR
+void st7920_flush();
+
+// The displayed pixel at 0 <= x < LCD_WIDTH, 0 <= y < LCD_HEIGHT, from
+// GDRAM, mapped as lcdlib maps the panel
+bool st7920_pixel(uint8_t x, uint8_t y);
+
+// Write the displayed graphics as a binary PBM
+void st7920_write_pbm(FILE *f);
+
+// Write DDRAM as four lines of sixteen characters
+void st7920_write_text(FILE *f);
+
+#endif /* ST7920_H_ */
@@ -0,0 +1,16 @@
+/*
+ * util/delay.h
+ *
+ * Host stand in for the avr-libc header. Delays don't wait, they add to
+ * the modeled bus time in st7920.c.
+ */
+
+#ifndef LCDHOST_UTIL_DELAY_H_
+#define LCDHOST_UTIL_DELAY_H_
+
+void host_delay_us(double us);
+
+#define _delay_us(us) host_delay_us(us)
+#define _delay_ms(ms) host_delay_us((ms) * 1000.0)
+
+#endif /* LCDHOST_UTIL_DELAY_H_ */
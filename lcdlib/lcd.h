@@ -26,6 +26,9 @@
  *
  * Also bridged JP1 and JP2 to use onboard pot for contrast control.
  *
+ * With LCD_TRANSPORT_USART (see lcd_config.h), E goes to XCK == PD4 == D4
+ * and RW to TXD == PD1 == D1 instead.
+ *
  * The trickiest part of getting this right was the control of the reset pin.
  * I found it quite finicky, and needing to be cycled just-so.
  */
@@ -35,6 +38,13 @@
 #define LCD_H_
 
 #include <avr/pgmspace.h>
+#include <stdbool.h>
+
+#include "lcd_config.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
 
 // Utility function to initialze SPI in a mode suitable for the LCD d_buffer
 void spi_init(void);
@@ -42,6 +52,9 @@ void spi_init(void);
 // Utility function to send a byte via SPI, without receiving
 void spi_send(uint8_t b);
 
+// Wait until the last byte sent has left the transport
+void spi_flush(void);
+
 // Reset, as per page 34 of 7920 data sheet
 void lcd_reset();
 
@@ -54,38 +67,456 @@ void lcd_instruction(uint8_t ins);
 // Sends the given data in ST7920 format, via SPI
 void lcd_data(uint8_t data);
 
+// Sends n bytes of data with a single sync byte, from RAM or flash
+void lcd_data_block(const uint8_t *data, uint16_t n);
+void lcd_data_block_p(const uint8_t *data, uint16_t n);
+
 // Sets the text cursor to the given line and column
 void lcd_set_cursor(uint8_t line, uint8_t col);
 
 // Utility function to send a string constant
 void lcd_send_str_p(PGM_P p);
 
+// Utility function to send a string from RAM
+void lcd_send_str(const char *s);
+
+//
+// Shadow text screen, in lcd_textbuf.c
+// Write into t_buffer, directly or with lcd_text_printf(), then call
+// lcd_text_flush() to send only the characters that changed. The display
+// must be showing text, as after lcd_reset().
+#define LCD_TEXT_LINES 4
+#define LCD_TEXT_COLS 16
+extern char t_buffer[LCD_TEXT_LINES][LCD_TEXT_COLS];
+
+// Blank t_buffer and note the display as blank. Call after lcd_reset() or
+// lcd_clear(), before using t_buffer.
+void lcd_text_reset();
+
+// Blank t_buffer, to be sent by the next flush
+void lcd_text_clear();
+
+// Format into t_buffer at line 0-3, character column 0-15, without a
+// terminating 0 and cut off at the end of the line. Returns the number of characters written.
+uint8_t lcd_text_printf(uint8_t line, uint8_t col, const char *fmt, ...);
+uint8_t lcd_text_printf_p(uint8_t line, uint8_t col, PGM_P fmt, ...);
+
+// Send the parts of t_buffer which differ from what was last sent. DDRAM
+// holds characters in pairs, so a change to either of a pair sends both.
+void lcd_text_flush();
+
+//
+// User glyphs, in lcd_glyph.c
+// A glyph is 16 rows of two bytes in PROGMEM, leftmost pixel in the top
+// bit. CGRAM holds four at a time. The display must be showing text.
+
+// Return the character code showing the glyph, loading it into CGRAM if
+// it isn't there already. The code goes in the second byte of a cell
+// whose first byte is 0. Loading replaces the glyph asked for least
+// recently, wherever it is on the screen, so show at most four at once.
+uint8_t lcd_glyph_p(const uint8_t *glyph);
+
+// Put a glyph in the t_buffer cell holding line, col
+void lcd_text_glyph_p(uint8_t line, uint8_t col, const uint8_t *glyph);
+
+// Forget what CGRAM holds, as after power up
+void lcd_glyph_reset();
+
+// Panel geometry, from LCD_WIDTH and LCD_HEIGHT
+#if LCD_WIDTH % 16 || LCD_WIDTH > 256 || LCD_HEIGHT > 64
+#error "LCD_WIDTH must be a multiple of 16 up to 256, and LCD_HEIGHT at most 64"
+#endif
+#define LCD_ROW_BYTES (LCD_WIDTH / 8)
+#define LCD_ROW_WORDS (LCD_WIDTH / 16)
+
+// The ST7920 drives 32 rows of up to 256 pixels. A 64 row panel of 128
+// pixels is folded, its bottom half being the right half of GDRAM lines
+// 0-31. Other panels take GDRAM lines 0-63 as their rows.
+#define LCD_GDRAM_FOLD (LCD_HEIGHT > 32 && LCD_WIDTH <= 128)
+#if LCD_GDRAM_FOLD
+#define LCD_GDRAM_LINES (LCD_HEIGHT / 2)
+#else
+#define LCD_GDRAM_LINES LCD_HEIGHT
+#endif
+
+// Rows of the screen held in d_buffer, starting from LCD_BUFFER_TOP.
+// Without bands that is the whole screen.
+#if LCD_BAND_ROWS
+#if LCD_BAND_ROWS > LCD_HEIGHT
+#error "LCD_BAND_ROWS must be at most LCD_HEIGHT"
+#endif
+extern uint8_t d_band_top;
+#define LCD_BUFFER_TOP d_band_top
+#define LCD_BUFFER_ROWS LCD_BAND_ROWS
+#else
+#define LCD_BUFFER_TOP 0
+#define LCD_BUFFER_ROWS LCD_HEIGHT
+#endif
+#define LCD_BUFFER_SIZE (LCD_ROW_BYTES * LCD_BUFFER_ROWS)
+
 // Graphic buffer display RAM
-// Layout is 64 Rows of 16 Bytes
-extern uint8_t d_buffer[1024];
+// Layout is LCD_BUFFER_ROWS Rows of LCD_ROW_BYTES Bytes
+extern uint8_t d_buffer[LCD_BUFFER_SIZE];
+
+// Words of d_buffer changed since the last refresh
+// One entry per row, bit n set when pixels 16n to 16n+15 have changed
+#if LCD_ROW_WORDS > 8
+typedef uint16_t lcd_dirty_t;
+#else
+typedef uint8_t lcd_dirty_t;
+#endif
+#define LCD_DIRTY_ALL ((lcd_dirty_t) ((1UL << LCD_ROW_WORDS) - 1))
+extern lcd_dirty_t d_dirty[LCD_BUFFER_ROWS];
+
+// Bits of a d_dirty entry for the words holding pixels x0 to x1 inclusive
+lcd_dirty_t display_span_mask(uint8_t x0, uint8_t x1);
 
+#if LCD_BAND_ROWS
+// Paint the whole display one band at a time. For each band, d_buffer is
+// cleared and pointed at the band's rows, then draw() is called to draw
+// the whole picture. Drawing is clipped to the band, so draw() need not
+// know about bands. It must draw the same picture every time it is
+// called within one display_render(). Pass NULL for a blank display.
+// Display will then be in graphics mode.
+void display_render(void (*draw)());
+#else
 //
 // Call this to paint the d_buffer RAM onto the display
 // Display will then be in graphics mode. Call lcd_reset() to go back to text mode
 void display_refresh();
 
+// Paint only the parts of d_buffer marked in d_dirty.
+// The display must already hold the rest of the picture, so call
+// display_refresh() once after lcd_reset() before using this.
+// Small gaps between changed words are sent again where that is quicker
+// than setting a new address.
+void display_refresh_dirty();
+
+// Paint the w by h pixel rectangle at x, y, widened to whole 16 pixel
+// words. The time taken depends only on the rectangle, so this suits
+// readouts updated at a fixed rate. A pending display_scroll() stays
+// pending, as the rows it brings into view may lie outside the rectangle,
+// until the next display_refresh(), display_refresh_dirty() or
+// display_swap() sends them and then the scroll.
+void display_refresh_rect(uint8_t x, uint8_t y, uint8_t w, uint8_t h);
+
+// Scroll d_buffer up by 'rows', blanking the rows at the bottom. The
+// controller's vertical scroll moves what is already on the display, so
+// the next display_refresh_dirty() or display_swap() sends only the
+// rows scrolled into view. Those are the bottom 'rows' of each 32 row
+// half of a 128 by 64 panel, and of the whole screen otherwise. The
+// scroll takes effect at the end of that refresh.
+void display_scroll(uint8_t rows);
+
+// GDRAM line shown at the top of the screen, or of each half of a
+// 128 by 64 panel. The refresh functions add it to every address.
+extern uint8_t d_scroll;
+#endif
+
+// Bytes sent by the refresh or render functions, and the bytes that a
+// full refresh of each frame, one row at a time, would have sent. Zero
+// them at will. The async functions count as the frame goes out, so read
+// these while display_busy() is false.
+typedef struct {
+    uint32_t sent;
+    uint32_t naive;
+} display_stats_t;
+extern display_stats_t display_stats;
+
+// Bytes a full refresh sent before it was planned, and still the naive
+// count for each frame: mode set, then for each row an address set and
+// its bytes
+#define LCD_NAIVE_BYTES ((2 + LCD_HEIGHT * (2 + LCD_ROW_BYTES)) * 3)
+
+// Mark all of d_buffer as dirty. Call this after writing d_buffer directly.
+void display_invalidate();
+
+#if LCD_DOUBLE_BUFFER
+// Copy of what the display is showing, kept up to date by the refresh
+// functions
+extern uint8_t d_front[LCD_BUFFER_SIZE];
+
+// Paint only the words of d_buffer that differ from d_front.
+// As with display_refresh_dirty(), only words marked in d_dirty are
+// considered, but of those only the ones which really changed are sent.
+void display_swap();
+#endif
+
 // Clear d_buffer RAM to empty
 void display_clear();
 
 // Set a bit on the d_buffer
-// 0 <= x < 128, 0 <= y < 64
+// 0 <= x < LCD_WIDTH, 0 <= y < LCD_HEIGHT. With LCD_BAND_ROWS, points
+// outside the band are skipped.
 void display_set(uint8_t x, uint8_t y);
 
 // A version of display_set that checks bounds
 void display_set_check(int x, int y);
 
-// Draw a line with Bresenhan's algorithm
+// Mark the w by h pixel rectangle at x, y as dirty.
+// Call this after writing part of d_buffer directly.
+void display_mark_dirty(uint8_t x, uint8_t y, uint8_t w, uint8_t h);
+
+// Set a horizontal line of w pixels starting at x, y
+void display_hline(uint8_t x, uint8_t y, uint8_t w);
+
+// Set pixels x0 to x1 inclusive of row y, without clipping except to the
+// band. Unlike display_hline(), this can cover the whole of a 256 pixel
+// row.
+void display_span(uint8_t x0, uint8_t x1, uint8_t y);
+
+// Set a vertical line of h pixels starting at x, y
+void display_vline(uint8_t x, uint8_t y, uint8_t h);
+
+// Set every pixel of the w by h rectangle at x, y
+void display_fill_rect(uint8_t x, uint8_t y, uint8_t w, uint8_t h);
+
+// Clear every pixel of the w by h rectangle at x, y
+void display_clear_rect(uint8_t x, uint8_t y, uint8_t w, uint8_t h);
+
+// Ways to combine a bitmap with d_buffer
+#define DISPLAY_OR 0 // set pixels set in the bitmap
+#define DISPLAY_AND 1 // clear pixels clear in the bitmap
+#define DISPLAY_XOR 2 // invert pixels set in the bitmap
+#define DISPLAY_COPY 3 // replace pixels with the bitmap
+
+// Draw a w by h PROGMEM bitmap with its top left corner at x, y, clipped
+// to the screen. Rows are (w + 7) / 8 bytes, leftmost pixel in the top bit.
+// 'op' is one of the DISPLAY_ raster operations above.
+void display_blit_p(const uint8_t *bitmap, int x, int y, uint8_t w, uint8_t h,
+        uint8_t op);
+
+// A proportional font, held in PROGMEM along with all of its tables.
+// Each glyph is a bitmap as for display_blit_p, 'height' rows high.
+typedef struct {
+    uint8_t first; // character code of the first glyph
+    uint8_t count; // number of glyphs
+    uint8_t height; // rows in every glyph
+    uint8_t spacing; // blank columns between glyphs
+    const uint8_t *widths; // width of each glyph
+    const uint16_t *offsets; // start of each glyph in 'bitmaps'
+    const uint8_t *bitmaps;
+    // Triples of left character, right character and signed change to
+    // the gap between them, ending with 0. May be NULL.
+    const uint8_t *kerning;
+} font_t;
+
+// Printable ASCII, 8 rows high with descenders
+extern const font_t font_small PROGMEM;
+
+// Draw a string with the top left of the first glyph at x, y. Returns the
+// x coordinate just past the last glyph. 'op' is DISPLAY_OR to draw over
+// the background, or DISPLAY_COPY to replace it; the gaps between glyphs
+// are cleared too.
+int display_text(const font_t *font, int x, int y, const char *s,
+        uint8_t op);
+int display_text_p(const font_t *font, int x, int y, PGM_P s, uint8_t op);
+
+// Width in pixels of a string as display_text would draw it
+int display_text_width(const font_t *font, const char *s);
+int display_text_width_p(const font_t *font, PGM_P s);
+
+// Draw a line with Bresenhan's algorithm, including both end points.
+// The line is clipped to the screen, so the ends may be off it.
 // http://en.wikipedia.org/wiki/Bresenham's_line_algorithm
-void display_line(uint8_t x0, uint8_t y0, uint8_t x1, uint8_t y1);
+void display_line(int x0, int y0, int x1, int y1);
 
 // An implementation of the midpoint circle algorithm
 // http://en.wikipedia.org/wiki/Midpoint_circle_algorithm
 // 'cx' and 'cy' denote the offset of the circle centre from the origin.
-void display_circle(uint8_t cx, uint8_t cy, uint8_t radius);
+void display_circle(int cx, int cy, uint8_t radius);
+
+//
+// Filled shapes, ellipses and arcs, in lcd_shapes.c
+// All are clipped to the screen and drawn as horizontal spans.
+// Angles are in degrees clockwise from 3 o'clock. Arcs run clockwise from
+// 'start' to 'end'.
+
+void display_fill_circle(int cx, int cy, uint8_t radius);
+
+// Ellipse with horizontal radius rx and vertical radius ry
+void display_ellipse(int cx, int cy, uint8_t rx, uint8_t ry);
+void display_fill_ellipse(int cx, int cy, uint8_t rx, uint8_t ry);
+
+// Part of a circle outline
+void display_arc(int cx, int cy, uint8_t radius, int start, int end);
+
+// Filled sector of a circle, as for a pie chart or gauge
+void display_fill_arc(int cx, int cy, uint8_t radius, int start, int end);
+
+//
+// Compressed images, in lcd_image.c
+// An image is a bitmap in PROGMEM packed with PackBits, made from a PBM
+// file by lcdhost/imgconv.c. Its first two bytes are the bytes in each
+// row and the number of rows.
+
+// Unpack an image into d_buffer with its top left at x, y, replacing the
+// pixels under it, and mark them dirty. x is rounded down to a multiple
+// of 8.
+void display_image_p(const uint8_t *image, int x, int y);
+
+// Send an image as the whole screen, with its top left at the top left
+// and the rest blank, unpacking a GDRAM line at a time without using
+// d_buffer. A pending display_scroll() takes effect at the end. d_buffer
+// then no longer matches the display, so use display_refresh() before
+// going back to display_refresh_dirty().
+void lcd_image_p(const uint8_t *image);
+
+//
+// Dithering, in lcd_dither.c
+// Rows of 8 bit gray, from 0 for black (a set pixel) to 255 for white,
+// are dithered into d_buffer one at a time, so no grayscale picture need
+// be held. Rows are clipped to the screen.
+#define DITHER_BAYER 0 // ordered, fast, with a regular pattern
+#define DITHER_FLOYD 1 // Floyd-Steinberg error diffusion, smoother
+
+typedef struct {
+    int x, y; // left end of the next row
+    uint8_t w; // pixels in each row
+    uint8_t mode; // DITHER_BAYER or DITHER_FLOYD
+    int16_t *errors; // error carried to the row below
+} dither_t;
+
+// Start a picture w pixels wide with its top left at x, y. DITHER_FLOYD
+// needs 'errors' of w int16_t for it to keep; DITHER_BAYER takes NULL.
+void dither_begin(dither_t *d, uint8_t mode, int x, int y, uint8_t w,
+        int16_t *errors);
+
+// Dither the next row of w gray bytes into d_buffer, replacing the pixels
+// under it, and mark them dirty
+void dither_row(dither_t *d, const uint8_t *gray);
+
+//
+// Retained scene, in lcd_scene.c
+// The scene holds up to LCD_SCENE_ITEMS shapes, ORed together to make the
+// picture. Each item is drawn only when it or something near it changes.
+// Functions adding an item return its id, or SCENE_NONE if the scene is
+// full. Strings are drawn from where they are, so keep them in place
+// while they are in the scene. Don't draw into d_buffer another way while
+// using the scene, except within display_render().
+#define SCENE_NONE 0xff
+
+uint8_t scene_line(int x0, int y0, int x1, int y1);
+uint8_t scene_circle(int cx, int cy, uint8_t radius);
+
+// A filled rectangle, which may be the full width of a 256 pixel panel
+uint8_t scene_rect(int x, int y, int w, int h);
+
+uint8_t scene_text(const font_t *font, int x, int y, const char *s);
+uint8_t scene_text_p(const font_t *font, int x, int y, PGM_P s);
+uint8_t scene_bitmap_p(const uint8_t *bitmap, int x, int y, uint8_t w,
+        uint8_t h);
+
+// Take an item out of the scene
+void scene_remove(uint8_t id);
+
+// Move an item by dx, dy
+void scene_move(uint8_t id, int dx, int dy);
+
+// Call after changing the string of a text item
+void scene_changed(uint8_t id);
+
+// Take every item out of the scene
+void scene_clear();
+
+// Draw every item. Use as the draw function for display_render(), or
+// after display_clear() to draw the whole scene from scratch.
+void scene_draw();
+
+#if !LCD_BAND_ROWS
+// Bring d_buffer up to date with the scene, clearing and drawing only
+// around what has changed, and marking in d_dirty only the words that
+// may have. Follow with display_refresh_dirty() or display_swap().
+void scene_update();
+#endif
+
+#if !LCD_BAND_ROWS
+//
+// Strip chart, in lcd_chart.c
+// Each sample is drawn as one column, sweeping left to right and wrapping
+// round, and only the rows it changes are marked dirty. Follow each
+// chart_add(), or a few, with display_refresh_dirty() or
+// display_refresh_dirty_async(). Not available with LCD_BAND_ROWS.
+typedef struct {
+    uint8_t x, y, w, h; // area of the screen
+    int lo, hi; // samples shown at the bottom and top rows, lo < hi
+    uint8_t col; // column the next sample goes in
+    uint8_t last; // row of the last sample
+    uint8_t *spans; // first and last row drawn in each column
+} chart_t;
+
+// Set up a chart on the w by h rectangle at x, y and clear it. 'spans'
+// is 2 * w bytes for the chart to keep.
+void chart_init(chart_t *c, uint8_t x, uint8_t y, uint8_t w, uint8_t h,
+        int lo, int hi, uint8_t *spans);
+
+// Draw the next sample
+void chart_add(chart_t *c, int sample);
+
+//
+// Interrupt driven transmit, in lcd_async.c
+// Uses the SPI interrupt and Timer2. While display_busy() is true, use only
+// these functions to talk to the LCD. Not available with LCD_BAND_ROWS.
+
+// Queue an instruction or data byte to be sent in the background.
+// Waits if the queue is full. Don't call from an interrupt handler.
+// Each is followed by the wait lcd_instruction() or lcd_data() would
+// make, and a clear by the wait of lcd_clear().
+void lcd_queue_instruction(uint8_t ins);
+void lcd_queue_data(uint8_t data);
+
+// True while queued bytes or a frame are still being sent
+bool display_busy();
+
+// Start painting d_buffer onto the display in the background.
+// If a frame is already being sent, waits until it has been generated.
+// Drawing into d_buffer before display_busy() goes false may tear.
+void display_refresh_async();
+
+// As display_refresh_async(), but only the words marked in d_dirty
+void display_refresh_dirty_async();
+#endif
+
+#if LCD_GRAY_ROWS
+//
+// Grayscale, in lcd_graphics.c and lcd_async.c
+// The top LCD_GRAY_ROWS rows have a second bitplane, d_gray, laid out like
+// d_buffer. A pixel's shade is 2 if it is set in d_buffer plus 1 if it is
+// set in d_gray. The planes are shown in turn, d_buffer for two ticks of
+// Timer1 and d_gray for one, so shade 3 is black, 2 dark gray and 1 light
+// gray. Uses Timer1 as well as the interrupts of lcd_async.c.
+extern uint8_t d_gray[LCD_GRAY_ROWS * LCD_ROW_BYTES];
+
+// Set every pixel of the w by h rectangle at x, y to a shade of 0-3.
+// Below the gray rows, shades 2 and 3 set pixels and 0 and 1 clear them.
+void display_fill_shade(uint8_t x, uint8_t y, uint8_t w, uint8_t h,
+        uint8_t shade);
+void display_shade(uint8_t x, uint8_t y, uint8_t shade);
+
+// Start showing the planes in turn, with hz ticks a second, at least 4.
+// Each tick sends in the background the words which differ between the
+// planes, if it changes plane, and those marked in d_dirty. Draw as
+// usual, but use no other refresh or lcd_ function until
+// display_gray_stop(), which leaves d_buffer on the display.
+void display_gray_start(uint8_t hz);
+void display_gray_stop();
+
+// Counts since display_gray_start() or the last display_gray_counters()
+typedef struct {
+    uint16_t ticks; // Timer1 interrupts
+    uint16_t frames; // planes sent
+    uint16_t late; // ticks skipped as a plane was still being sent
+    uint32_t bus_us; // time the bus was busy, from the settle times
+} display_gray_counters_t;
+
+// Copy the counts into c and zero them. Planes are sent at
+// frames * hz / ticks a second, and the bus is busy for
+// bus_us / (ticks * 1000000 / hz) of the time.
+void display_gray_counters(display_gray_counters_t *c);
+#endif
+
+#ifdef __cplusplus
+}
+#endif
 
 #endif /* LCD_H_ */
@@ -0,0 +1,435 @@
+/*
+ * lcd_async.c
+ *
+ * Interrupt driven LCD transmit.
+ *
+ * Each ST7920 transfer is three SPI bytes followed by a settle time while
+ * the controller executes it. Here the transfer complete interrupt, of the
+ * SPI port or of USART0 with LCD_TRANSPORT_USART, feeds the three bytes
+ * and Timer2 (in CTC mode) times the settle, so the main loop keeps
+ * running while a frame streams out.
+ *
+ * Transfers come from a small ring of queued entries first, then from a
+ * frame generator which walks d_buffer one row at a time.
+ *
+ * With LCD_GRAY_ROWS, Timer1 ticks at a steady rate and each tick starts
+ * a frame of one of the two bitplanes: d_buffer for two ticks, then d_gray
+ * for one. The display keeps what it was last sent, so a frame changing
+ * plane need only send the words where the planes differ, and one
+ * staying on the same plane only what has been drawn since.
+ *
+ * This file claims SPI_STC_vect or USART_TX_vect, TIMER2_COMPA_vect, and
+ * with LCD_GRAY_ROWS TIMER1_COMPA_vect. It is only linked when one of its
+ * functions is used. Don't use the blocking lcd_* functions while
+ * display_busy() is true. Not available when rendering in bands, as there
+ * is no whole frame to send.
+ */
+
+#include <avr/interrupt.h>
+#include <avr/io.h>
+#include <avr/pgmspace.h>
+#include <inttypes.h>
+#include <stdbool.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "lcd.h"
+
+#if !LCD_BAND_ROWS
+
+// Entries are the sync byte in the top 8 bits and the payload in the bottom
+#define SYNC_INSTRUCTION 0b11111000 // 5 1 bits, RS = 0, RW = 0
+#define SYNC_DATA 0b11111010 // 5 1 bits, RS = 1, RW = 0
+
+// The transmit register and its transfer complete interrupt
+#if LCD_TRANSPORT == LCD_TRANSPORT_USART
+#define TX_DATA UDR0
+#define TX_vect USART_TX_vect
+// TXC0 is left set by blocking sends, so clear it before enabling
+#define TX_INTERRUPT_ON() (UCSR0A = _BV(TXC0), UCSR0B |= _BV(TXCIE0))
+#define TX_INTERRUPT_OFF() (UCSR0B &= ~_BV(TXCIE0))
+#else
+#define TX_DATA SPDR
+#define TX_vect SPI_STC_vect
+#define TX_INTERRUPT_ON() (SPCR |= _BV(SPIE))
+#define TX_INTERRUPT_OFF() (SPCR &= ~_BV(SPIE))
+#endif
+
+// Settle times, by the classes of instruction lcd_base.c waits for
+#if LCD_TIMING == LCD_TIMING_TABLE
+#define CLEAR_US LCD_CLEAR_US
+#define ADDRESS_US LCD_ADDRESS_US
+#define INSTRUCTION_US LCD_INSTRUCTION_US
+#define DATA_US LCD_DATA_US
+#else
+// lcd_clear() waits a further 2ms after the usual 72us
+#define CLEAR_US 2072
+#define ADDRESS_US 72
+#define INSTRUCTION_US 72
+#define DATA_US 40
+#endif
+
+// Timer2 counts at F_CPU / 8, which only reaches 128us at 16MHz, so a
+// clear is timed at F_CPU / 256
+#if F_CPU < 8000000UL
+#error "lcd_async.c needs F_CPU of 8MHz or more to time the settles"
+#endif
+#define SETTLE_TICKS(us) ((uint8_t) ((F_CPU / 8000000UL) * (us) - 1))
+#define CLEAR_TICKS \
+        ((uint8_t) ((F_CPU / 1000000UL * CLEAR_US + 255) / 256 - 1))
+#define CLOCK_8 _BV(CS21)
+#define CLOCK_256 (_BV(CS22) | _BV(CS21))
+
+#if F_CPU / 1000000UL * CLEAR_US > 256UL * 256
+#error "LCD_CLEAR_US is too long for Timer2"
+#endif
+#if (F_CPU / 8000000UL) * ADDRESS_US > 256 \
+        || (F_CPU / 8000000UL) * INSTRUCTION_US > 256 \
+        || (F_CPU / 8000000UL) * DATA_US > 256
+#error "LCD_ADDRESS_US, LCD_INSTRUCTION_US or LCD_DATA_US is too long"
+#endif
+
+// Must be a power of 2
+#define RING_SIZE 16
+
+static uint16_t ring[RING_SIZE];
+static volatile uint8_t ring_head; // next free slot, written by main
+static volatile uint8_t ring_tail; // next entry to send, written by ISR
+
+// True from the first entry until the ring and frame are both empty
+static volatile bool busy;
+
+// Entry currently on the wire, and how many of its bytes have been sent
+static uint16_t current;
+static uint8_t phase;
+
+// Timer2 compare value and clock select for the settle after current
+static uint8_t settle_ticks;
+static uint8_t settle_clock;
+
+// Frame generator state.
+// f_row is -1 before the first row and LCD_HEIGHT when the frame is done.
+// f_mask holds the words still to send in this row, shifted so that
+// bit 0 is f_word. f_step counts through vertical address, horizontal
+// address, high byte and low byte, then the two scroll instructions
+// after the last row if f_scroll is set. f_src is the row being sent.
+static volatile int8_t f_row = LCD_HEIGHT;
+static uint8_t f_word;
+static lcd_dirty_t f_mask;
+static uint8_t f_step;
+static bool f_full;
+static bool f_scroll;
+static const uint8_t *f_src;
+
+#if LCD_GRAY_ROWS
+// Plane of the gray rows being sent, 1 for d_gray, and whether it differs
+// from the plane sent last
+static uint8_t f_plane;
+static bool f_diff;
+
+static volatile display_gray_counters_t _counters;
+
+//
+// Add the words of a gray row which differ between the planes, if the
+// plane has changed, and send the row from the plane being shown
+static void _gray_row() {
+    uint8_t *low = d_gray + f_row * LCD_ROW_BYTES;
+    if (f_diff) {
+        for (uint8_t i = 0; i < LCD_ROW_BYTES; i += 2) {
+            if (low[i] != f_src[i] || low[i + 1] != f_src[i + 1]) {
+                f_mask |= (lcd_dirty_t) 1 << (i >> 1);
+            }
+        }
+    }
+    if (f_plane) {
+        f_src = low;
+    }
+}
+#endif
+
+//
+// Produce the next entry of the frame, or return false at the end
+static bool _frame_next(uint16_t *e) {
+    for (;;) {
+        if (f_row >= LCD_HEIGHT) {
+            return false;
+        }
+        switch (f_step) {
+        case 0:
+            if (!f_mask) {
+                if (f_row == LCD_HEIGHT - 1 && f_scroll) {
+                    f_step = 4;
+                    continue;
+                }
+                // To next row
+                f_row++;
+                if (f_row < LCD_HEIGHT) {
+                    f_mask = f_full ? LCD_DIRTY_ALL : d_dirty[f_row];
+                    d_dirty[f_row] = 0;
+                    f_word = 0;
+                    f_src = d_buffer + f_row * LCD_ROW_BYTES;
+#if LCD_GRAY_ROWS
+                    if (f_row < LCD_GRAY_ROWS) {
+                        _gray_row();
+                    }
+#endif
+                }
+                continue;
+            }
+            while (!(f_mask & 1)) {
+                f_mask >>= 1;
+                f_word++;
+            }
+            f_step = 1;
+            display_stats.sent += 3;
+            *e = (SYNC_INSTRUCTION << 8) | 0b10000000
+                    | ((f_row % LCD_GDRAM_LINES + d_scroll) & 63);
+            return true;
+        case 1:
+            f_step = 2;
+            display_stats.sent += 3;
+            // The bottom rows of a folded panel are the right of the line
+            *e = (SYNC_INSTRUCTION << 8) | 0b10000000
+                    | (f_row < LCD_GDRAM_LINES ? 0 : LCD_ROW_WORDS) | f_word;
+            return true;
+        case 2:
+            f_step = 3;
+            display_stats.sent += 3;
+            *e = (SYNC_DATA << 8) | f_src[f_word * 2];
+            return true;
+        case 3:
+            display_stats.sent += 3;
+            *e = (SYNC_DATA << 8) | f_src[f_word * 2 + 1];
+            f_mask >>= 1;
+            f_word++;
+            // Words in a run follow on without a new address
+            f_step = (f_mask & 1) ? 2 : 0;
+            return true;
+        case 4:
+            // Scroll position, in case display_scroll() has moved it. As
+            // in the blocking refresh, this comes after the rows it
+            // brings into view.
+            f_step = 5;
+            display_stats.sent += 3;
+            *e = (SYNC_INSTRUCTION << 8) | 0b00000011; // scroll address select
+            return true;
+        default:
+            f_row = LCD_HEIGHT;
+            display_stats.sent += 3;
+            *e = (SYNC_INSTRUCTION << 8) | 0b01000000 | d_scroll;
+            return true;
+        }
+    }
+}
+
+//
+// Set up the settle after an entry, as lcd_instruction() or lcd_data()
+// would wait
+static void _settle(uint16_t e) {
+    uint8_t b = e;
+    settle_clock = CLOCK_8;
+    if ((e >> 8) == SYNC_DATA) {
+        settle_ticks = SETTLE_TICKS(DATA_US);
+    } else if (b == 0b00000001) {
+        settle_ticks = CLEAR_TICKS;
+        settle_clock = CLOCK_256;
+    } else if (b & 0b11000000) {
+        // Any of the set address instructions
+        settle_ticks = SETTLE_TICKS(ADDRESS_US);
+    } else {
+        settle_ticks = SETTLE_TICKS(INSTRUCTION_US);
+    }
+}
+
+//
+// Begin sending the next entry, or go idle. Called with interrupts off.
+static void _start_next() {
+    uint16_t e;
+    if (ring_tail != ring_head) {
+        e = ring[ring_tail];
+        ring_tail = (ring_tail + 1) & (RING_SIZE - 1);
+    } else if (!_frame_next(&e)) {
+        TX_INTERRUPT_OFF();
+        busy = false;
+        return;
+    }
+    _settle(e);
+#if LCD_GRAY_ROWS
+    // Three bytes at 8MHz, then the settle
+    _counters.bus_us += 3 + (uint32_t) (settle_ticks + 1)
+            * (settle_clock == CLOCK_8 ? 8 : 256) / (F_CPU / 1000000UL);
+#endif
+    current = e;
+    phase = 0;
+    TX_DATA = e >> 8;
+    TX_INTERRUPT_ON();
+}
+
+//
+// Start the engine if it is idle. Called with interrupts off.
+static void _kick() {
+    if (busy) {
+        return;
+    }
+    busy = true;
+    TCCR2A = _BV(WGM21); // CTC mode
+    TCCR2B = 0; // stopped
+    TIMSK2 = _BV(OCIE2A);
+    _start_next();
+}
+
+//
+// Queue a sync byte and payload, waiting while the ring is full
+static void _queue(uint8_t sync, uint8_t b) {
+    uint8_t next = (ring_head + 1) & (RING_SIZE - 1);
+    while (next == ring_tail) {
+        // ring full, wait for the ISR to take one
+    }
+    ring[ring_head] = (sync << 8) | b;
+    cli();
+    ring_head = next;
+    _kick();
+    sei();
+}
+
+ISR(TX_vect) {
+    phase++;
+    if (phase == 1) {
+        TX_DATA = current & 0xf0;
+    } else if (phase == 2) {
+        TX_DATA = current << 4;
+    } else {
+        // All three bytes sent. Give the controller time to act.
+        OCR2A = settle_ticks;
+        TCNT2 = 0;
+        TIFR2 = _BV(OCF2A);
+        TCCR2B = settle_clock;
+    }
+}
+
+ISR(TIMER2_COMPA_vect) {
+    TCCR2B = 0;
+    _start_next();
+}
+
+void lcd_queue_instruction(uint8_t ins) {
+    _queue(SYNC_INSTRUCTION, ins);
+}
+
+void lcd_queue_data(uint8_t data) {
+    _queue(SYNC_DATA, data);
+}
+
+bool display_busy() {
+    return busy;
+}
+
+//
+// Start the frame generator. Called with interrupts off.
+static void _start_frame(bool full) {
+    display_stats.naive += LCD_NAIVE_BYTES;
+    f_full = full;
+    f_mask = 0;
+    f_step = 0;
+    f_row = -1;
+    _kick();
+}
+
+//
+// Wait for any frame already being generated, then queue the set up for
+// another
+static void _frame_setup() {
+    while (f_row < LCD_HEIGHT) {
+        // previous frame still going
+    }
+    // Initialize graphics mode
+    lcd_queue_instruction(0b00110100); // 8bit data, extended instructions
+    lcd_queue_instruction(0b00110110); // +graphics
+    display_stats.sent += 6;
+}
+
+//
+// Start a frame, after any frame already being sent
+static void _refresh_async(bool full) {
+    _frame_setup();
+    cli();
+    f_scroll = true;
+    _start_frame(full);
+    sei();
+}
+
+void display_refresh_async() {
+    _refresh_async(true);
+}
+
+void display_refresh_dirty_async() {
+    _refresh_async(false);
+}
+
+#if LCD_GRAY_ROWS
+// Ticks through the planes, and whether the next frame is the first
+static uint8_t _tick;
+static bool _first;
+
+ISR(TIMER1_COMPA_vect) {
+    _counters.ticks++;
+    if (f_row < LCD_HEIGHT) {
+        // Try this plane again next tick, to keep the weights
+        _counters.late++;
+        return;
+    }
+    uint8_t plane = _tick == 2;
+    _tick = plane ? 0 : _tick + 1;
+    f_diff = plane != f_plane;
+    f_plane = plane;
+    _counters.frames++;
+    // The first frame sets the scroll position, as other frames do
+    f_scroll = _first;
+    _start_frame(_first);
+    _first = false;
+}
+
+void display_gray_start(uint8_t hz) {
+    _frame_setup();
+    cli();
+    _tick = 0;
+    _first = true;
+    memset((void *) &_counters, 0, sizeof(_counters));
+    // Timer1 in CTC mode at F_CPU / 64
+    TCCR1A = 0;
+    TCCR1B = _BV(WGM12) | _BV(CS11) | _BV(CS10);
+    OCR1A = F_CPU / 64 / hz - 1;
+    TCNT1 = 0;
+    TIMSK1 = _BV(OCIE1A);
+    sei();
+}
+
+void display_gray_stop() {
+    TIMSK1 = 0;
+    TCCR1B = 0;
+    while (f_row < LCD_HEIGHT) {
+        // last plane still going
+    }
+    if (f_plane) {
+        // Leave the display showing d_buffer
+        cli();
+        f_plane = 0;
+        f_diff = true;
+        f_scroll = false;
+        _start_frame(false);
+        sei();
+        while (f_row < LCD_HEIGHT) {
+            // waiting
+        }
+    }
+    f_diff = false;
+}
+
+void display_gray_counters(display_gray_counters_t *c) {
+    cli();
+    *c = _counters;
+    memset((void *) &_counters, 0, sizeof(_counters));
+    sei();
+}
+#endif
+#endif
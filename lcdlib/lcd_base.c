@@ -17,6 +17,44 @@
 
 #include "lcd.h"
 
+#if LCD_TRANSPORT == LCD_TRANSPORT_USART
+void spi_init(void) {
+    // Baud rate must be 0 while the transmitter is enabled
+    UBRR0 = 0;
+
+    // XCK as an output makes this the master. Set TXD and PB0 as outputs.
+    DDRD |= _BV(PD4) | _BV(PD1);
+    DDRB |= 0x1;
+    PORTB |= 0x1; // set PB0 - nonreset
+
+    // Master SPI mode, MSB first, clock idle high, sample data on trailing
+    // edge, as for the SPI port
+    UCSR0C = _BV(UMSEL01) | _BV(UMSEL00) | _BV(UCPHA0) | _BV(UCPOL0);
+    UCSR0B = _BV(TXEN0);
+
+    // Clock Frequency = Fosc / (2 * (UBRR0 + 1)) = 8MHz
+    UBRR0 = 0;
+}
+
+//
+// Queue a byte as soon as the transmit buffer has room, without waiting
+// for it to go.
+static inline void _send(uint8_t b) {
+    while (!(UCSR0A & _BV(UDRE0))) {
+        // busy wait
+    }
+    UDR0 = b;
+    // Clear transmit complete. This follows the write so that the byte
+    // before can't set it again, and b takes longer to go than this does.
+    UCSR0A = _BV(TXC0);
+}
+
+static inline void _flush() {
+    while (!(UCSR0A & _BV(TXC0))) {
+        // busy wait
+    }
+}
+#else
 void spi_init(void) {
     // SPI enable, master mode, clock idle high, sample data on trailing edge
     // Clock Frequency = Fosc / 2 = 8MHz
@@ -28,31 +66,101 @@ void spi_init(void) {
     PORTB = 0x1; // set PB0 - nonreset
 }
 
-void spi_send(uint8_t b) {
+static inline void _send(uint8_t b) {
     SPDR = b;
     while (!(SPSR & 0x80)) {
         // busy wait
     }
 }
 
+// Each byte has already gone by the time _send() returns
+static inline void _flush() {
+}
+#endif
+
+void spi_send(uint8_t b) {
+    _send(b);
+}
+
+void spi_flush(void) {
+    _flush();
+}
+
+#if LCD_TIMING == LCD_TIMING_TABLE
+//
+// Wait for the given instruction to execute.
+// Each branch passes a constant to _delay_us so that it compiles to a
+// simple loop.
+static void _instruction_wait(uint8_t ins) {
+    if (ins == 0b00000001) {
+        _delay_us(LCD_CLEAR_US);
+    } else if (ins & 0b11000000) {
+        // Any of the set address instructions
+        _delay_us(LCD_ADDRESS_US);
+    } else {
+        _delay_us(LCD_INSTRUCTION_US);
+    }
+}
+#endif
+
 void lcd_instruction(uint8_t ins) {
-    spi_send(0b11111000); // 5 1 bits, RS = 0, RW = 0
-    spi_send(ins & 0xf0);
-    spi_send(ins << 4);
+    _send(0b11111000); // 5 1 bits, RS = 0, RW = 0
+    _send(ins & 0xf0);
+    _send(ins << 4);
+    _flush();
+#if LCD_TIMING == LCD_TIMING_TABLE
+    _instruction_wait(ins);
+#else
     _delay_us(72);
+#endif
 }
 
 void lcd_data(uint8_t data) {
-    spi_send(0b11111010); // 5 1 bits, RS = 1, RW = 0
-    spi_send(data & 0xf0);
-    spi_send(data << 4);
+    _send(0b11111010); // 5 1 bits, RS = 1, RW = 0
+    _send(data & 0xf0);
+    _send(data << 4);
+    _flush();
+#if LCD_TIMING == LCD_TIMING_TABLE
+    _delay_us(LCD_DATA_US);
+#else
     _delay_us(40);
+#endif
+}
+
+//
+// Send n bytes of data from RAM, or from flash if 'pgm' is set.
+//
+// The controller takes any number of nibble pairs after one sync byte, so
+// the sync is sent once for the block rather than once per byte.
+static void _data_block(const uint8_t *data, uint16_t n, bool pgm) {
+    _send(0b11111010); // 5 1 bits, RS = 1, RW = 0
+    for (; n; n--, data++) {
+        uint8_t b = pgm ? pgm_read_byte(data) : *data;
+        _send(b & 0xf0);
+        _send(b << 4);
+        _flush();
+#if LCD_TIMING == LCD_TIMING_TABLE
+        _delay_us(LCD_DATA_US);
+#else
+        _delay_us(40);
+#endif
+    }
+}
+
+void lcd_data_block(const uint8_t *data, uint16_t n) {
+    _data_block(data, n, false);
+}
+
+void lcd_data_block_p(const uint8_t *data, uint16_t n) {
+    _data_block(data, n, true);
 }
 
 // Clears the text screen
 void lcd_clear() {
     lcd_instruction(0b00000001); // clear
+#if LCD_TIMING != LCD_TIMING_TABLE
     _delay_ms(2); // Needs 1.62ms delay
+#endif
 }
 
 // Reset, as per page 34 of 7920 data sheet
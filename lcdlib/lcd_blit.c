@@ -0,0 +1,83 @@
+/*
+ * lcd_blit.c
+ *
+ * LCD Library bitmap copy.
+ *
+ * Bitmaps are laid out like d_buffer: rows of (w + 7) / 8 bytes, with the
+ * leftmost pixel in the top bit of the first byte. Each source byte is
+ * shifted into place and merged into the two d_buffer bytes it straddles,
+ * so a row costs a few byte operations rather than one per pixel.
+ */
+
+#include <avr/io.h>
+#include <avr/pgmspace.h>
+#include <inttypes.h>
+#include <stdbool.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "lcd.h"
+
+//
+// Combine source bits s into *d, touching only the bits set in mask m
+static void _apply(uint8_t *d, uint8_t s, uint8_t m, uint8_t op) {
+    switch (op) {
+    case DISPLAY_OR:
+        *d |= s;
+        break;
+    case DISPLAY_AND:
+        *d &= ~(m & ~s);
+        break;
+    case DISPLAY_XOR:
+        *d ^= s;
+        break;
+    default: // DISPLAY_COPY
+        *d = (*d & ~m) | s;
+        break;
+    }
+}
+
+void display_blit_p(const uint8_t *bitmap, int x, int y, uint8_t w, uint8_t h,
+        uint8_t op) {
+    // From here on y is a row of d_buffer
+    y -= LCD_BUFFER_TOP;
+    if (!w || !h || x >= LCD_WIDTH || y >= LCD_BUFFER_ROWS || x + w <= 0
+            || y + h <= 0) {
+        return;
+    }
+    uint8_t stride = (w + 7) >> 3;
+
+    // Clip rows
+    uint8_t r0 = y < 0 ? -y : 0;
+    uint8_t r1 = y + h > LCD_BUFFER_ROWS ? LCD_BUFFER_ROWS - y : h;
+
+    // Destination byte of the first source byte, which may be off the
+    // left edge. avr-gcc shifts signed values arithmetically.
+    int8_t col = x >> 3;
+    uint8_t shift = x & 7;
+
+    // Valid bits of the last source byte of each row
+    uint8_t last_mask = 0xff << ((8 - (w & 7)) & 7);
+
+    const uint8_t *src = bitmap + r0 * stride;
+    uint8_t *row = d_buffer + (y + r0) * LCD_ROW_BYTES;
+    for (uint8_t r = r0; r < r1; r++, row += LCD_ROW_BYTES) {
+        int8_t c = col;
+        for (uint8_t i = 0; i < stride; i++, c++) {
+            uint8_t m = i == stride - 1 ? last_mask : 0xff;
+            uint8_t s = pgm_read_byte(src) & m;
+            src++;
+            if (c >= 0 && c < LCD_ROW_BYTES) {
+                _apply(row + c, s >> shift, m >> shift, op);
+            }
+            if (shift && c + 1 >= 0 && c + 1 < LCD_ROW_BYTES) {
+                _apply(row + c + 1, s << (8 - shift), m << (8 - shift), op);
+            }
+        }
+    }
+
+    // Mark the clipped rectangle
+    int x0 = x < 0 ? 0 : x;
+    int x1 = x + w > LCD_WIDTH ? LCD_WIDTH : x + w;
+    display_mark_dirty(x0, y + r0 + LCD_BUFFER_TOP, x1 - x0, r1 - r0);
+}
@@ -0,0 +1,92 @@
+/*
+ * lcd_chart.c
+ *
+ * LCD Library strip chart.
+ *
+ * Samples are drawn left to right across the chart and wrap round to the
+ * left edge, like an oscilloscope sweep, rather than moving what is
+ * already drawn. Each sample is joined to the one before by a vertical
+ * segment in its own column. The segment in each column is remembered,
+ * so the sweep erases just that, and the segment in the column after it
+ * to leave a gap showing where the sweep is. Only the rows of those few
+ * segments are marked dirty, so a refresh after each sample sends a
+ * handful of words.
+ */
+
+#include <avr/io.h>
+#include <avr/pgmspace.h>
+#include <inttypes.h>
+#include <stdbool.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "lcd.h"
+
+#if !LCD_BAND_ROWS
+
+// No sample yet, or nothing drawn in a column
+#define NONE 0xff
+
+void chart_init(chart_t *c, uint8_t x, uint8_t y, uint8_t w, uint8_t h,
+        int lo, int hi, uint8_t *spans) {
+    c->x = x;
+    c->y = y;
+    c->w = w;
+    c->h = h;
+    c->lo = lo;
+    c->hi = hi;
+    c->col = 0;
+    c->last = NONE;
+    c->spans = spans;
+    memset(spans, NONE, 2 * w);
+    display_clear_rect(x, y, w, h);
+}
+
+//
+// Screen row of a sample, clamped to the chart
+static uint8_t _row(const chart_t *c, int sample) {
+    if (sample < c->lo) {
+        sample = c->lo;
+    } else if (sample > c->hi) {
+        sample = c->hi;
+    }
+    // In long throughout, as hi - lo alone can pass 32767
+    return c->y + c->h - 1
+            - (uint8_t) (((long) sample - c->lo) * (c->h - 1)
+                    / ((long) c->hi - c->lo));
+}
+
+//
+// Clear whatever segment column col holds
+static void _erase(chart_t *c, uint8_t col) {
+    uint8_t *s = c->spans + col * 2;
+    if (s[0] != NONE) {
+        display_clear_rect(c->x + col, s[0], 1, s[1] - s[0] + 1);
+        s[0] = NONE;
+    }
+}
+
+void chart_add(chart_t *c, int sample) {
+    uint8_t row = _row(c, sample);
+    uint8_t top = row, bottom = row;
+    // Join on to the last sample, without drawing over its row again
+    if (c->last != NONE) {
+        if (row > c->last) {
+            top = c->last + 1;
+        } else if (row < c->last) {
+            bottom = c->last - 1;
+        }
+    }
+    c->last = row;
+
+    _erase(c, c->col);
+    display_vline(c->x + c->col, top, bottom - top + 1);
+    c->spans[c->col * 2] = top;
+    c->spans[c->col * 2 + 1] = bottom;
+
+    if (++c->col == c->w) {
+        c->col = 0;
+    }
+    _erase(c, c->col);
+}
+#endif
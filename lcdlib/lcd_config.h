@@ -0,0 +1,116 @@
+/*
+ * lcd_config.h
+ *
+ * Compile time options for lcdlib. Each may be overridden with -D on the
+ * compiler command line. The library and the application must be built
+ * with the same settings.
+ */
+
+#ifndef LCD_CONFIG_H_
+#define LCD_CONFIG_H_
+
+//
+// Panel size in pixels. The 12864 module is 128 by 64, and 192 by 64 and
+// 256 by 32 modules are also supported. d_buffer takes LCD_WIDTH / 8
+// bytes for each row, so a smaller panel leaves more RAM free.
+#ifndef LCD_WIDTH
+#define LCD_WIDTH 128
+#endif
+
+#ifndef LCD_HEIGHT
+#define LCD_HEIGHT 64
+#endif
+
+//
+// How long to wait for the controller after each transfer.
+//
+// LCD_TIMING_FIXED waits the worst case after every transfer: 72us after
+// an instruction, 40us after data and a further 2ms after clear.
+//
+// LCD_TIMING_TABLE waits a per command time from the table below. Clear
+// and other instructions get the ST7920 data sheet's 1.6ms and 72us. The
+// data sheet quotes 72us for setting an address and writing RAM too, but
+// FIXED already trusts RAM writes to 40us, and these two are nearly all of
+// a refresh. The defaults cut them to 48us and 24us, two thirds and three
+// fifths of the fixed waits. Modules vary: if pixels go astray, raise
+// these, and demo_benchmark shows what each costs.
+//
+// Busy flag polling is not offered: the ST7920 serial interface can't be
+// read, and RW is wired to MOSI anyway.
+#define LCD_TIMING_FIXED 0
+#define LCD_TIMING_TABLE 1
+
+#ifndef LCD_TIMING
+#define LCD_TIMING LCD_TIMING_FIXED
+#endif
+
+// Clear display
+#ifndef LCD_CLEAR_US
+#define LCD_CLEAR_US 1600
+#endif
+
+// Set DDRAM, CGRAM, GDRAM or scroll address
+#ifndef LCD_ADDRESS_US
+#define LCD_ADDRESS_US 48
+#endif
+
+// Any other instruction
+#ifndef LCD_INSTRUCTION_US
+#define LCD_INSTRUCTION_US 72
+#endif
+
+// Write to DDRAM, CGRAM or GDRAM
+#ifndef LCD_DATA_US
+#define LCD_DATA_US 24
+#endif
+
+//
+// Which peripheral drives the display.
+//
+// LCD_TRANSPORT_SPI uses the SPI port, wired as in lcd.h.
+//
+// LCD_TRANSPORT_USART runs USART0 as an SPI master instead, leaving the
+// SPI port free for other devices. Wire E to XCK (PD4, D4) and RW to TXD
+// (PD1, D1). Its transmit register is double buffered, so the bytes of a
+// transfer go out back to back. Serial on USART0 is then unavailable.
+#define LCD_TRANSPORT_SPI 0
+#define LCD_TRANSPORT_USART 1
+
+#ifndef LCD_TRANSPORT
+#define LCD_TRANSPORT LCD_TRANSPORT_SPI
+#endif
+
+//
+// Set to a number of rows to render in bands rather than keep the whole
+// screen in RAM. d_buffer then holds just that many rows, and
+// display_render() calls back to draw the picture once for each band.
+// 0 keeps the whole screen in d_buffer.
+#ifndef LCD_BAND_ROWS
+#define LCD_BAND_ROWS 0
+#endif
+
+//
+// Most items the retained scene in lcd_scene.c can hold. Each takes 13
+// bytes of RAM, which is only used if the scene is.
+#ifndef LCD_SCENE_ITEMS
+#define LCD_SCENE_ITEMS 16
+#endif
+
+//
+// Set to 1 to keep a second buffer the size of d_buffer holding what the
+// display shows, for display_swap(). Needs the RAM of a 1280 or 2560.
+#ifndef LCD_DOUBLE_BUFFER
+#define LCD_DOUBLE_BUFFER 0
+#endif
+
+//
+// Set to a number of rows at the top of the screen to show in four
+// shades of gray, by flicking between two bitplanes under a timer
+// interrupt. The second plane, d_gray, takes LCD_ROW_BYTES bytes for each
+// row, so 32 rows of a 128 by 64 panel fit alongside d_buffer on a 328.
+// 0 leaves gray out.
+#ifndef LCD_GRAY_ROWS
+#define LCD_GRAY_ROWS 0
+#endif
+
+#endif /* LCD_CONFIG_H_ */
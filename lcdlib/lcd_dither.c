@@ -0,0 +1,150 @@
+/*
+ * lcd_dither.c
+ *
+ * LCD Library dithering of grayscale rows.
+ *
+ * Rows of 8 bit gray are turned into pixels as they arrive, so a picture
+ * can be computed or read a row at a time without holding it all. Bayer
+ * dithering compares each gray byte with a threshold from a 4 by 4
+ * matrix, tiled from the top left of the screen so that neighbouring
+ * pictures line up. Floyd-Steinberg dithering instead passes on the error
+ * of each pixel to the pixels right of and below it, keeping the error
+ * for the row below in one row of int16_t.
+ *
+ * Either way the pixels of a row are packed into bytes, which are then
+ * shifted into place in d_buffer as display_blit_p() does.
+ */
+
+#include <avr/io.h>
+#include <avr/pgmspace.h>
+#include <inttypes.h>
+#include <stdbool.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "lcd.h"
+
+//
+// Bayer matrix scaled to gray. A pixel is set where its gray is below.
+static const uint8_t _bayer[4][4] PROGMEM = {
+    { 8, 136, 40, 168 },
+    { 200, 72, 232, 104 },
+    { 56, 184, 24, 152 },
+    { 248, 120, 216, 88 },
+};
+
+void dither_begin(dither_t *d, uint8_t mode, int x, int y, uint8_t w,
+        int16_t *errors) {
+    d->x = x;
+    d->y = y;
+    d->w = w;
+    d->mode = mode;
+    d->errors = errors;
+    if (mode == DITHER_FLOYD) {
+        memset(errors, 0, w * sizeof(int16_t));
+    }
+}
+
+//
+// Pack a row of w pixels into bits by comparing each gray byte with the
+// thresholds t, which repeat every four pixels
+static void _bayer_row(const uint8_t *gray, uint8_t w, const uint8_t *t,
+        uint8_t *bits) {
+    uint8_t t0 = t[0], t1 = t[1], t2 = t[2], t3 = t[3];
+    for (uint8_t b = w >> 3; b; b--, gray += 8) {
+        *bits++ = (gray[0] < t0) << 7 | (gray[1] < t1) << 6
+                | (gray[2] < t2) << 5 | (gray[3] < t3) << 4
+                | (gray[4] < t0) << 3 | (gray[5] < t1) << 2
+                | (gray[6] < t2) << 1 | (gray[7] < t3);
+    }
+    uint8_t n = w & 7;
+    if (n) {
+        uint8_t s = 0;
+        for (uint8_t k = 0; k < n; k++) {
+            s = (s << 1) | (gray[k] < t[k & 3]);
+        }
+        *bits = s << (8 - n);
+    }
+}
+
+//
+// Pack a row of w pixels into bits, adding in the error e left by the
+// row above and leaving in e the error for the row below
+static void _floyd_row(const uint8_t *gray, uint8_t w, int16_t *e,
+        uint8_t *bits) {
+    // Error passed on to the next pixel of this row, and so far to the
+    // pixels below the last one and this one
+    int16_t right = 0, below_last = 0, below = 0;
+    uint8_t s = 0;
+    for (uint8_t i = 0; i < w; i++) {
+        int16_t err = gray[i] + e[i] + right;
+        s <<= 1;
+        if (err < 128) {
+            s |= 1;
+        } else {
+            err -= 255;
+        }
+        right = (err * 7) >> 4;
+        if (i) {
+            e[i - 1] = below_last + ((err * 3) >> 4);
+        }
+        below_last = below + ((err * 5) >> 4);
+        below = err >> 4;
+        if ((i & 7) == 7) {
+            *bits++ = s;
+        }
+    }
+    if (w & 7) {
+        *bits = s << (8 - (w & 7));
+    }
+    if (w) {
+        e[w - 1] = below_last;
+    }
+}
+
+void dither_row(dither_t *d, const uint8_t *gray) {
+    int x = d->x;
+    int y = d->y++;
+    uint8_t bits[32];
+
+    // Rows off d_buffer are still dithered, to carry the error on
+    if (d->mode == DITHER_FLOYD) {
+        _floyd_row(gray, d->w, d->errors, bits);
+    }
+    y -= LCD_BUFFER_TOP;
+    if (!d->w || y < 0 || y >= LCD_BUFFER_ROWS || x >= LCD_WIDTH
+            || x + d->w <= 0) {
+        return;
+    }
+    if (d->mode == DITHER_BAYER) {
+        // Thresholds for the columns of this row, from the first pixel
+        uint8_t t[4];
+        for (uint8_t i = 0; i < 4; i++) {
+            t[i] = pgm_read_byte(
+                    &_bayer[(y + LCD_BUFFER_TOP) & 3][(x + i) & 3]);
+        }
+        _bayer_row(gray, d->w, t, bits);
+    }
+
+    // Shift each byte into place over the two d_buffer bytes it straddles
+    uint8_t *row = d_buffer + y * LCD_ROW_BYTES;
+    uint8_t stride = (d->w + 7) >> 3;
+    uint8_t last_mask = 0xff << ((8 - (d->w & 7)) & 7);
+    int c = x >> 3;
+    uint8_t shift = x & 7;
+    for (uint8_t i = 0; i < stride; i++, c++) {
+        uint8_t m = i == stride - 1 ? last_mask : 0xff;
+        uint8_t s = bits[i];
+        if (c >= 0 && c < LCD_ROW_BYTES) {
+            row[c] = (row[c] & ~(m >> shift)) | (s >> shift);
+        }
+        if (shift && c + 1 >= 0 && c + 1 < LCD_ROW_BYTES) {
+            uint8_t rm = m << (8 - shift);
+            row[c + 1] = (row[c + 1] & ~rm) | (uint8_t) (s << (8 - shift));
+        }
+    }
+
+    int x0 = x < 0 ? 0 : x;
+    int x1 = x + d->w > LCD_WIDTH ? LCD_WIDTH : x + d->w;
+    display_mark_dirty(x0, y + LCD_BUFFER_TOP, x1 - x0, 1);
+}
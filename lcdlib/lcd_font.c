@@ -0,0 +1,111 @@
+/*
+ * lcd_font.c
+ *
+ * LCD Library proportional text in graphics mode.
+ *
+ * Glyphs are drawn into d_buffer with display_blit_p, so text and graphics
+ * can be mixed on one screen without switching the controller back to its
+ * character mode.
+ */
+
+#include <avr/io.h>
+#include <avr/pgmspace.h>
+#include <inttypes.h>
+#include <stdbool.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "lcd.h"
+
+//
+// Change to the gap between characters a and b
+static int8_t _kern(const font_t *f, char a, char b) {
+    const uint8_t *k = f->kerning;
+    if (!k) {
+        return 0;
+    }
+    uint8_t l;
+    while (l = pgm_read_byte(k), l) {
+        if (l == (uint8_t) a && pgm_read_byte(k + 1) == (uint8_t) b) {
+            return (int8_t) pgm_read_byte(k + 2);
+        }
+        k += 3;
+    }
+    return 0;
+}
+
+//
+// Clear the w column gap before a glyph at x, y, h rows high, clipped to
+// the screen here as display_clear_rect() takes only unsigned coordinates
+static void _clear_gap(int x, int y, int8_t w, uint8_t h) {
+    if (x >= LCD_WIDTH || x + w <= 0 || y >= LCD_HEIGHT || y + h <= 0) {
+        return;
+    }
+    if (x < 0) {
+        w += x;
+        x = 0;
+    }
+    if (y < 0) {
+        h += y;
+        y = 0;
+    }
+    display_clear_rect(x, y, w, h);
+}
+
+//
+// Lay out a string, drawing it if 'draw' is set, and return the x
+// coordinate just past the last glyph. Characters the font lacks are
+// skipped.
+static int _text(const font_t *font, int x, int y, const char *s, bool pgm,
+        bool draw, uint8_t op) {
+    font_t f;
+    memcpy_P(&f, font, sizeof(f));
+
+    char prev = 0;
+    for (;;) {
+        char c = pgm ? pgm_read_byte(s) : *s;
+        if (!c) {
+            break;
+        }
+        s++;
+        uint8_t i = c - f.first;
+        if (i >= f.count) {
+            continue;
+        }
+        if (prev) {
+            int8_t gap = f.spacing + _kern(&f, prev, c);
+            if (draw && op == DISPLAY_COPY && gap > 0) {
+                _clear_gap(x, y, gap, f.height);
+            }
+            x += gap;
+        }
+        uint8_t w = pgm_read_byte(f.widths + i);
+        if (draw) {
+            if (x >= LCD_WIDTH) {
+                break;
+            }
+            display_blit_p(f.bitmaps + pgm_read_word(f.offsets + i), x, y, w,
+                    f.height, op);
+        }
+        x += w;
+        prev = c;
+    }
+    return x;
+}
+
+int display_text(const font_t *font, int x, int y, const char *s,
+        uint8_t op) {
+    return _text(font, x, y, s, false, true, op);
+}
+
+int display_text_p(const font_t *font, int x, int y, PGM_P s, uint8_t op) {
+    return _text(font, x, y, s, true, true, op);
+}
+
+int display_text_width(const font_t *font, const char *s) {
+    return _text(font, 0, 0, s, false, false, 0);
+}
+
+int display_text_width_p(const font_t *font, PGM_P s) {
+    return _text(font, 0, 0, s, true, false, 0);
+}
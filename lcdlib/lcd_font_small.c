@@ -0,0 +1,913 @@
+/*
+ * lcd_font_small.c
+ *
+ * A proportional font of the printable ASCII characters, 8 rows high.
+ * Capitals and digits are 7 rows, and row 7 is for descenders.
+ */
+
+#include <avr/pgmspace.h>
+#include <inttypes.h>
+
+#include "lcd.h"
+
+static const uint8_t widths[] PROGMEM = {
+    3, 1, 3, 5, 5, 5, 5, 1, 2, 2, 5, 5, 2, 4, 1, 5,
+    5, 3, 5, 5, 5, 5, 5, 5, 5, 5, 1, 2, 4, 4, 4, 5,
+    5, 5, 5, 5, 5, 5, 5, 5, 5, 3, 5, 5, 5, 5, 5, 5,
+    5, 5, 5, 5, 5, 5, 5, 5, 5, 5, 5, 2, 5, 2, 5, 5,
+    2, 4, 4, 4, 4, 4, 3, 4, 4, 1, 2, 4, 2, 5, 4, 4,
+    4, 4, 3, 4, 3, 4, 5, 5, 4, 4, 4, 3, 1, 3, 5,
+};
+
+static const uint16_t offsets[] PROGMEM = {
+    0, 8, 16, 24, 32, 40, 48, 56, 64, 72, 80, 88,
+    96, 104, 112, 120, 128, 136, 144, 152, 160, 168, 176, 184,
+    192, 200, 208, 216, 224, 232, 240, 248, 256, 264, 272, 280,
+    288, 296, 304, 312, 320, 328, 336, 344, 352, 360, 368, 376,
+    384, 392, 400, 408, 416, 424, 432, 440, 448, 456, 464, 472,
+    480, 488, 496, 504, 512, 520, 528, 536, 544, 552, 560, 568,
+    576, 584, 592, 600, 608, 616, 624, 632, 640, 648, 656, 664,
+    672, 680, 688, 696, 704, 712, 720, 728, 736, 744, 752,
+};
+
+static const uint8_t bitmaps[] PROGMEM = {
+    // ' '
+    0x00, // ...
+    0x00, // ...
+    0x00, // ...
+    0x00, // ...
+    0x00, // ...
+    0x00, // ...
+    0x00, // ...
+    0x00, // ...
+    // '!'
+    0x80, // #
+    0x80, // #
+    0x80, // #
+    0x80, // #
+    0x80, // #
+    0x00, // .
+    0x80, // #
+    0x00, // .
+    // '"'
+    0xa0, // #.#
+    0xa0, // #.#
+    0x00, // ...
+    0x00, // ...
+    0x00, // ...
+    0x00, // ...
+    0x00, // ...
+    0x00, // ...
+    // '#'
+    0x50, // .#.#.
+    0x50, // .#.#.
+    0xf8, // #####
+    0x50, // .#.#.
+    0xf8, // #####
+    0x50, // .#.#.
+    0x50, // .#.#.
+    0x00, // .....
+    // '$'
+    0x20, // ..#..
+    0x78, // .####
+    0xa0, // #.#..
+    0x70, // .###.
+    0x28, // ..#.#
+    0xf0, // ####.
+    0x20, // ..#..
+    0x00, // .....
+    // '%'
+    0xc0, // ##...
+    0xc8, // ##..#
+    0x10, // ...#.
+    0x20, // ..#..
+    0x40, // .#...
+    0x98, // #..##
+    0x18, // ...##
+    0x00, // .....
+    // '&'
+    0x60, // .##..
+    0x90, // #..#.
+    0xa0, // #.#..
+    0x40, // .#...
+    0xa8, // #.#.#
+    0x90, // #..#.
+    0x68, // .##.#
+    0x00, // .....
+    // '\''
+    0x80, // #
+    0x80, // #
+    0x00, // .
+    0x00, // .
+    0x00, // .
+    0x00, // .
+    0x00, // .
+    0x00, // .
+    // '('
+    0x40, // .#
+    0x80, // #.
+    0x80, // #.
+    0x80, // #.
+    0x80, // #.
+    0x80, // #.
+    0x40, // .#
+    0x00, // ..
+    // ')'
+    0x80, // #.
+    0x40, // .#
+    0x40, // .#
+    0x40, // .#
+    0x40, // .#
+    0x40, // .#
+    0x80, // #.
+    0x00, // ..
+    // '*'
+    0x00, // .....
+    0x20, // ..#..
+    0xa8, // #.#.#
+    0x70, // .###.
+    0xa8, // #.#.#
+    0x20, // ..#..
+    0x00, // .....
+    0x00, // .....
+    // '+'
+    0x00, // .....
+    0x20, // ..#..
+    0x20, // ..#..
+    0xf8, // #####
+    0x20, // ..#..
+    0x20, // ..#..
+    0x00, // .....
+    0x00, // .....
+    // ','
+    0x00, // ..
+    0x00, // ..
+    0x00, // ..
+    0x00, // ..
+    0x00, // ..
+    0x40, // .#
+    0x40, // .#
+    0x80, // #.
+    // '-'
+    0x00, // ....
+    0x00, // ....
+    0x00, // ....
+    0xf0, // ####
+    0x00, // ....
+    0x00, // ....
+    0x00, // ....
+    0x00, // ....
+    // '.'
+    0x00, // .
+    0x00, // .
+    0x00, // .
+    0x00, // .
+    0x00, // .
+    0x00, // .
+    0x80, // #
+    0x00, // .
+    // '/'
+    0x08, // ....#
+    0x08, // ....#
+    0x10, // ...#.
+    0x20, // ..#..
+    0x40, // .#...
+    0x80, // #....
+    0x80, // #....
+    0x00, // .....
+    // '0'
+    0x70, // .###.
+    0x88, // #...#
+    0x98, // #..##
+    0xa8, // #.#.#
+    0xc8, // ##..#
+    0x88, // #...#
+    0x70, // .###.
+    0x00, // .....
+    // '1'
+    0x40, // .#.
+    0xc0, // ##.
+    0x40, // .#.
+    0x40, // .#.
+    0x40, // .#.
+    0x40, // .#.
+    0xe0, // ###
+    0x00, // ...
+    // '2'
+    0x70, // .###.
+    0x88, // #...#
+    0x08, // ....#
+    0x30, // ..##.
+    0x40, // .#...
+    0x80, // #....
+    0xf8, // #####
+    0x00, // .....
+    // '3'
+    0xf0, // ####.
+    0x08, // ....#
+    0x08, // ....#
+    0x70, // .###.
+    0x08, // ....#
+    0x08, // ....#
+    0xf0, // ####.
+    0x00, // .....
+    // '4'
+    0x10, // ...#.
+    0x30, // ..##.
+    0x50, // .#.#.
+    0x90, // #..#.
+    0xf8, // #####
+    0x10, // ...#.
+    0x10, // ...#.
+    0x00, // .....
+    // '5'
+    0xf8, // #####
+    0x80, // #....
+    0xf0, // ####.
+    0x08, // ....#
+    0x08, // ....#
+    0x88, // #...#
+    0x70, // .###.
+    0x00, // .....
+    // '6'
+    0x30, // ..##.
+    0x40, // .#...
+    0x80, // #....
+    0xf0, // ####.
+    0x88, // #...#
+    0x88, // #...#
+    0x70, // .###.
+    0x00, // .....
+    // '7'
+    0xf8, // #####
+    0x08, // ....#
+    0x10, // ...#.
+    0x20, // ..#..
+    0x40, // .#...
+    0x40, // .#...
+    0x40, // .#...
+    0x00, // .....
+    // '8'
+    0x70, // .###.
+    0x88, // #...#
+    0x88, // #...#
+    0x70, // .###.
+    0x88, // #...#
+    0x88, // #...#
+    0x70, // .###.
+    0x00, // .....
+    // '9'
+    0x70, // .###.
+    0x88, // #...#
+    0x88, // #...#
+    0x78, // .####
+    0x08, // ....#
+    0x10, // ...#.
+    0x60, // .##..
+    0x00, // .....
+    // ':'
+    0x00, // .
+    0x00, // .
+    0x80, // #
+    0x00, // .
+    0x00, // .
+    0x80, // #
+    0x00, // .
+    0x00, // .
+    // ';'
+    0x00, // ..
+    0x00, // ..
+    0x40, // .#
+    0x00, // ..
+    0x00, // ..
+    0x40, // .#
+    0x40, // .#
+    0x80, // #.
+    // '<'
+    0x10, // ...#
+    0x20, // ..#.
+    0x40, // .#..
+    0x80, // #...
+    0x40, // .#..
+    0x20, // ..#.
+    0x10, // ...#
+    0x00, // ....
+    // '='
+    0x00, // ....
+    0x00, // ....
+    0xf0, // ####
+    0x00, // ....
+    0xf0, // ####
+    0x00, // ....
+    0x00, // ....
+    0x00, // ....
+    // '>'
+    0x80, // #...
+    0x40, // .#..
+    0x20, // ..#.
+    0x10, // ...#
+    0x20, // ..#.
+    0x40, // .#..
+    0x80, // #...
+    0x00, // ....
+    // '?'
+    0x70, // .###.
+    0x88, // #...#
+    0x08, // ....#
+    0x10, // ...#.
+    0x20, // ..#..
+    0x00, // .....
+    0x20, // ..#..
+    0x00, // .....
+    // '@'
+    0x70, // .###.
+    0x88, // #...#
+    0xb8, // #.###
+    0xa8, // #.#.#
+    0xb8, // #.###
+    0x80, // #....
+    0x70, // .###.
+    0x00, // .....
+    // 'A'
+    0x70, // .###.
+    0x88, // #...#
+    0x88, // #...#
+    0xf8, // #####
+    0x88, // #...#
+    0x88, // #...#
+    0x88, // #...#
+    0x00, // .....
+    // 'B'
+    0xf0, // ####.
+    0x88, // #...#
+    0x88, // #...#
+    0xf0, // ####.
+    0x88, // #...#
+    0x88, // #...#
+    0xf0, // ####.
+    0x00, // .....
+    // 'C'
+    0x70, // .###.
+    0x88, // #...#
+    0x80, // #....
+    0x80, // #....
+    0x80, // #....
+    0x88, // #...#
+    0x70, // .###.
+    0x00, // .....
+    // 'D'
+    0xf0, // ####.
+    0x88, // #...#
+    0x88, // #...#
+    0x88, // #...#
+    0x88, // #...#
+    0x88, // #...#
+    0xf0, // ####.
+    0x00, // .....
+    // 'E'
+    0xf8, // #####
+    0x80, // #....
+    0x80, // #....
+    0xf0, // ####.
+    0x80, // #....
+    0x80, // #....
+    0xf8, // #####
+    0x00, // .....
+    // 'F'
+    0xf8, // #####
+    0x80, // #....
+    0x80, // #....
+    0xf0, // ####.
+    0x80, // #....
+    0x80, // #....
+    0x80, // #....
+    0x00, // .....
+    // 'G'
+    0x70, // .###.
+    0x88, // #...#
+    0x80, // #....
+    0xb8, // #.###
+    0x88, // #...#
+    0x88, // #...#
+    0x78, // .####
+    0x00, // .....
+    // 'H'
+    0x88, // #...#
+    0x88, // #...#
+    0x88, // #...#
+    0xf8, // #####
+    0x88, // #...#
+    0x88, // #...#
+    0x88, // #...#
+    0x00, // .....
+    // 'I'
+    0xe0, // ###
+    0x40, // .#.
+    0x40, // .#.
+    0x40, // .#.
+    0x40, // .#.
+    0x40, // .#.
+    0xe0, // ###
+    0x00, // ...
+    // 'J'
+    0x38, // ..###
+    0x10, // ...#.
+    0x10, // ...#.
+    0x10, // ...#.
+    0x10, // ...#.
+    0x90, // #..#.
+    0x60, // .##..
+    0x00, // .....
+    // 'K'
+    0x88, // #...#
+    0x90, // #..#.
+    0xa0, // #.#..
+    0xc0, // ##...
+    0xa0, // #.#..
+    0x90, // #..#.
+    0x88, // #...#
+    0x00, // .....
+    // 'L'
+    0x80, // #....
+    0x80, // #....
+    0x80, // #....
+    0x80, // #....
+    0x80, // #....
+    0x80, // #....
+    0xf8, // #####
+    0x00, // .....
+    // 'M'
+    0x88, // #...#
+    0xd8, // ##.##
+    0xa8, // #.#.#
+    0xa8, // #.#.#
+    0x88, // #...#
+    0x88, // #...#
+    0x88, // #...#
+    0x00, // .....
+    // 'N'
+    0x88, // #...#
+    0x88, // #...#
+    0xc8, // ##..#
+    0xa8, // #.#.#
+    0x98, // #..##
+    0x88, // #...#
+    0x88, // #...#
+    0x00, // .....
+    // 'O'
+    0x70, // .###.
+    0x88, // #...#
+    0x88, // #...#
+    0x88, // #...#
+    0x88, // #...#
+    0x88, // #...#
+    0x70, // .###.
+    0x00, // .....
+    // 'P'
+    0xf0, // ####.
+    0x88, // #...#
+    0x88, // #...#
+    0xf0, // ####.
+    0x80, // #....
+    0x80, // #....
+    0x80, // #....
+    0x00, // .....
+    // 'Q'
+    0x70, // .###.
+    0x88, // #...#
+    0x88, // #...#
+    0x88, // #...#
+    0xa8, // #.#.#
+    0x90, // #..#.
+    0x68, // .##.#
+    0x00, // .....
+    // 'R'
+    0xf0, // ####.
+    0x88, // #...#
+    0x88, // #...#
+    0xf0, // ####.
+    0xa0, // #.#..
+    0x90, // #..#.
+    0x88, // #...#
+    0x00, // .....
+    // 'S'
+    0x78, // .####
+    0x80, // #....
+    0x80, // #....
+    0x70, // .###.
+    0x08, // ....#
+    0x08, // ....#
+    0xf0, // ####.
+    0x00, // .....
+    // 'T'
+    0xf8, // #####
+    0x20, // ..#..
+    0x20, // ..#..
+    0x20, // ..#..
+    0x20, // ..#..
+    0x20, // ..#..
+    0x20, // ..#..
+    0x00, // .....
+    // 'U'
+    0x88, // #...#
+    0x88, // #...#
+    0x88, // #...#
+    0x88, // #...#
+    0x88, // #...#
+    0x88, // #...#
+    0x70, // .###.
+    0x00, // .....
+    // 'V'
+    0x88, // #...#
+    0x88, // #...#
+    0x88, // #...#
+    0x88, // #...#
+    0x88, // #...#
+    0x50, // .#.#.
+    0x20, // ..#..
+    0x00, // .....
+    // 'W'
+    0x88, // #...#
+    0x88, // #...#
+    0x88, // #...#
+    0xa8, // #.#.#
+    0xa8, // #.#.#
+    0xa8, // #.#.#
+    0x50, // .#.#.
+    0x00, // .....
+    // 'X'
+    0x88, // #...#
+    0x88, // #...#
+    0x50, // .#.#.
+    0x20, // ..#..
+    0x50, // .#.#.
+    0x88, // #...#
+    0x88, // #...#
+    0x00, // .....
+    // 'Y'
+    0x88, // #...#
+    0x88, // #...#
+    0x88, // #...#
+    0x50, // .#.#.
+    0x20, // ..#..
+    0x20, // ..#..
+    0x20, // ..#..
+    0x00, // .....
+    // 'Z'
+    0xf8, // #####
+    0x08, // ....#
+    0x10, // ...#.
+    0x20, // ..#..
+    0x40, // .#...
+    0x80, // #....
+    0xf8, // #####
+    0x00, // .....
+    // '['
+    0xc0, // ##
+    0x80, // #.
+    0x80, // #.
+    0x80, // #.
+    0x80, // #.
+    0x80, // #.
+    0xc0, // ##
+    0x00, // ..
+    // '\\'
+    0x80, // #....
+    0x80, // #....
+    0x40, // .#...
+    0x20, // ..#..
+    0x10, // ...#.
+    0x08, // ....#
+    0x08, // ....#
+    0x00, // .....
+    // ']'
+    0xc0, // ##
+    0x40, // .#
+    0x40, // .#
+    0x40, // .#
+    0x40, // .#
+    0x40, // .#
+    0xc0, // ##
+    0x00, // ..
+    // '^'
+    0x20, // ..#..
+    0x50, // .#.#.
+    0x88, // #...#
+    0x00, // .....
+    0x00, // .....
+    0x00, // .....
+    0x00, // .....
+    0x00, // .....
+    // '_'
+    0x00, // .....
+    0x00, // .....
+    0x00, // .....
+    0x00, // .....
+    0x00, // .....
+    0x00, // .....
+    0x00, // .....
+    0xf8, // #####
+    // '`'
+    0x80, // #.
+    0x40, // .#
+    0x00, // ..
+    0x00, // ..
+    0x00, // ..
+    0x00, // ..
+    0x00, // ..
+    0x00, // ..
+    // 'a'
+    0x00, // ....
+    0x00, // ....
+    0x60, // .##.
+    0x10, // ...#
+    0x70, // .###
+    0x90, // #..#
+    0x70, // .###
+    0x00, // ....
+    // 'b'
+    0x80, // #...
+    0x80, // #...
+    0xe0, // ###.
+    0x90, // #..#
+    0x90, // #..#
+    0x90, // #..#
+    0xe0, // ###.
+    0x00, // ....
+    // 'c'
+    0x00, // ....
+    0x00, // ....
+    0x70, // .###
+    0x80, // #...
+    0x80, // #...
+    0x80, // #...
+    0x70, // .###
+    0x00, // ....
+    // 'd'
+    0x10, // ...#
+    0x10, // ...#
+    0x70, // .###
+    0x90, // #..#
+    0x90, // #..#
+    0x90, // #..#
+    0x70, // .###
+    0x00, // ....
+    // 'e'
+    0x00, // ....
+    0x00, // ....
+    0x60, // .##.
+    0x90, // #..#
+    0xf0, // ####
+    0x80, // #...
+    0x70, // .###
+    0x00, // ....
+    // 'f'
+    0x20, // ..#
+    0x40, // .#.
+    0xe0, // ###
+    0x40, // .#.
+    0x40, // .#.
+    0x40, // .#.
+    0x40, // .#.
+    0x00, // ...
+    // 'g'
+    0x00, // ....
+    0x00, // ....
+    0x70, // .###
+    0x90, // #..#
+    0x90, // #..#
+    0x70, // .###
+    0x10, // ...#
+    0x60, // .##.
+    // 'h'
+    0x80, // #...
+    0x80, // #...
+    0xe0, // ###.
+    0x90, // #..#
+    0x90, // #..#
+    0x90, // #..#
+    0x90, // #..#
+    0x00, // ....
+    // 'i'
+    0x80, // #
+    0x00, // .
+    0x80, // #
+    0x80, // #
+    0x80, // #
+    0x80, // #
+    0x80, // #
+    0x00, // .
+    // 'j'
+    0x40, // .#
+    0x00, // ..
+    0x40, // .#
+    0x40, // .#
+    0x40, // .#
+    0x40, // .#
+    0x40, // .#
+    0x80, // #.
+    // 'k'
+    0x80, // #...
+    0x80, // #...
+    0x90, // #..#
+    0xa0, // #.#.
+    0xc0, // ##..
+    0xa0, // #.#.
+    0x90, // #..#
+    0x00, // ....
+    // 'l'
+    0x80, // #.
+    0x80, // #.
+    0x80, // #.
+    0x80, // #.
+    0x80, // #.
+    0x80, // #.
+    0x40, // .#
+    0x00, // ..
+    // 'm'
+    0x00, // .....
+    0x00, // .....
+    0xd0, // ##.#.
+    0xa8, // #.#.#
+    0xa8, // #.#.#
+    0xa8, // #.#.#
+    0xa8, // #.#.#
+    0x00, // .....
+    // 'n'
+    0x00, // ....
+    0x00, // ....
+    0xe0, // ###.
+    0x90, // #..#
+    0x90, // #..#
+    0x90, // #..#
+    0x90, // #..#
+    0x00, // ....
+    // 'o'
+    0x00, // ....
+    0x00, // ....
+    0x60, // .##.
+    0x90, // #..#
+    0x90, // #..#
+    0x90, // #..#
+    0x60, // .##.
+    0x00, // ....
+    // 'p'
+    0x00, // ....
+    0x00, // ....
+    0xe0, // ###.
+    0x90, // #..#
+    0x90, // #..#
+    0xe0, // ###.
+    0x80, // #...
+    0x80, // #...
+    // 'q'
+    0x00, // ....
+    0x00, // ....
+    0x70, // .###
+    0x90, // #..#
+    0x90, // #..#
+    0x70, // .###
+    0x10, // ...#
+    0x10, // ...#
+    // 'r'
+    0x00, // ...
+    0x00, // ...
+    0xa0, // #.#
+    0xc0, // ##.
+    0x80, // #..
+    0x80, // #..
+    0x80, // #..
+    0x00, // ...
+    // 's'
+    0x00, // ....
+    0x00, // ....
+    0x70, // .###
+    0x80, // #...
+    0x60, // .##.
+    0x10, // ...#
+    0xe0, // ###.
+    0x00, // ....
+    // 't'
+    0x40, // .#.
+    0x40, // .#.
+    0xe0, // ###
+    0x40, // .#.
+    0x40, // .#.
+    0x40, // .#.
+    0x20, // ..#
+    0x00, // ...
+    // 'u'
+    0x00, // ....
+    0x00, // ....
+    0x90, // #..#
+    0x90, // #..#
+    0x90, // #..#
+    0x90, // #..#
+    0x70, // .###
+    0x00, // ....
+    // 'v'
+    0x00, // .....
+    0x00, // .....
+    0x88, // #...#
+    0x88, // #...#
+    0x88, // #...#
+    0x50, // .#.#.
+    0x20, // ..#..
+    0x00, // .....
+    // 'w'
+    0x00, // .....
+    0x00, // .....
+    0x88, // #...#
+    0x88, // #...#
+    0xa8, // #.#.#
+    0xa8, // #.#.#
+    0x50, // .#.#.
+    0x00, // .....
+    // 'x'
+    0x00, // ....
+    0x00, // ....
+    0x90, // #..#
+    0x90, // #..#
+    0x60, // .##.
+    0x90, // #..#
+    0x90, // #..#
+    0x00, // ....
+    // 'y'
+    0x00, // ....
+    0x00, // ....
+    0x90, // #..#
+    0x90, // #..#
+    0x90, // #..#
+    0x70, // .###
+    0x10, // ...#
+    0x60, // .##.
+    // 'z'
+    0x00, // ....
+    0x00, // ....
+    0xf0, // ####
+    0x10, // ...#
+    0x60, // .##.
+    0x80, // #...
+    0xf0, // ####
+    0x00, // ....
+    // '{'
+    0x20, // ..#
+    0x40, // .#.
+    0x40, // .#.
+    0x80, // #..
+    0x40, // .#.
+    0x40, // .#.
+    0x20, // ..#
+    0x00, // ...
+    // '|'
+    0x80, // #
+    0x80, // #
+    0x80, // #
+    0x80, // #
+    0x80, // #
+    0x80, // #
+    0x80, // #
+    0x00, // .
+    // '}'
+    0x80, // #..
+    0x40, // .#.
+    0x40, // .#.
+    0x20, // ..#
+    0x40, // .#.
+    0x40, // .#.
+    0x80, // #..
+    0x00, // ...
+    // '~'
+    0x00, // .....
+    0x00, // .....
+    0x40, // .#...
+    0xa8, // #.#.#
+    0x10, // ...#.
+    0x00, // .....
+    0x00, // .....
+    0x00, // .....
+};
+
+// Pairs of characters and the change to the gap between them
+static const uint8_t kerning[] PROGMEM = {
+    'A', 'V', (uint8_t) -1,
+    'V', 'A', (uint8_t) -1,
+    'A', 'T', (uint8_t) -1,
+    'T', 'A', (uint8_t) -1,
+    'A', 'Y', (uint8_t) -1,
+    'Y', 'A', (uint8_t) -1,
+    'L', 'T', (uint8_t) -1,
+    'L', 'Y', (uint8_t) -1,
+    'T', 'a', (uint8_t) -1,
+    'T', 'e', (uint8_t) -1,
+    'T', 'o', (uint8_t) -1,
+    'r', '.', (uint8_t) -1,
+    'r', ',', (uint8_t) -1,
+    'P', '.', (uint8_t) -1,
+    'F', '.', (uint8_t) -1,
+    0
+};
+
+const font_t font_small PROGMEM = {
+    ' ', 95, 8, 1, widths, offsets, bitmaps, kerning
+};
@@ -0,0 +1,60 @@
+/*
+ * lcd_glyph.c
+ *
+ * LCD Library cache of user glyphs in CGRAM.
+ *
+ * CGRAM holds four 16 by 16 glyphs, shown in text mode by the character
+ * codes 0, 2, 4 and 6. Each slot remembers which PROGMEM glyph it holds,
+ * so asking for a glyph already there costs nothing on the bus. Otherwise
+ * the least recently asked for slot is loaded, which takes an address
+ * instruction and 32 bytes of data.
+ */
+
+#include <avr/io.h>
+#include <avr/pgmspace.h>
+#include <inttypes.h>
+#include <stdbool.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "lcd.h"
+
+#define SLOTS 4
+
+//
+// Glyph in each slot, or NULL if unknown
+static const uint8_t *_glyph[SLOTS];
+
+//
+// Slots, most recently used first
+static uint8_t _order[SLOTS] = { 0, 1, 2, 3 };
+
+void lcd_glyph_reset() {
+    memset(_glyph, 0, sizeof(_glyph));
+}
+
+uint8_t lcd_glyph_p(const uint8_t *glyph) {
+    // Find the glyph, or stop at the least recently used slot
+    uint8_t i = 0;
+    while (i < SLOTS - 1 && _glyph[_order[i]] != glyph) {
+        i++;
+    }
+    uint8_t slot = _order[i];
+    if (_glyph[slot] != glyph) {
+        lcd_instruction(0b01000000 | (slot << 4)); // CGRAM address
+        lcd_data_block_p(glyph, 32);
+        _glyph[slot] = glyph;
+    }
+    memmove(_order + 1, _order, i);
+    _order[0] = slot;
+    return slot * 2;
+}
+
+void lcd_text_glyph_p(uint8_t line, uint8_t col, const uint8_t *glyph) {
+    if (line >= LCD_TEXT_LINES || col >= LCD_TEXT_COLS) {
+        return;
+    }
+    char *c = &t_buffer[line][col & ~1];
+    c[0] = 0;
+    c[1] = lcd_glyph_p(glyph);
+}
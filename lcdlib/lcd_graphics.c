@@ -6,8 +6,9 @@
  *
  * LCD Library graphics functions.
  *
- * This file defines the 1K byte graphics RAM. It is the only file in
- * this library which references that RAM block.
+ * This file defines the graphics RAM and the basic drawing
+ * functions on it. Other drawing functions may write the RAM directly,
+ * but must mark what they change with display_mark_dirty().
  */
 
 #include <avr/io.h>
@@ -21,110 +22,879 @@
 #include "lcd.h"
 
 //
-// Half the 328P's RAM
-// Lay out is 64 Rows of 16 Bytes
-uint8_t d_buffer[1024];
+// Half the 328P's RAM for a 128 by 64 panel, unless rendering in bands
+// Lay out is LCD_BUFFER_ROWS Rows of LCD_ROW_BYTES Bytes
+uint8_t d_buffer[LCD_BUFFER_SIZE];
+
+//
+// Dirty map. One entry per row, one bit per 16 pixel GDRAM word.
+// Bit 0 is the leftmost word.
+lcd_dirty_t d_dirty[LCD_BUFFER_ROWS];
+
+#if LCD_BAND_ROWS
+//
+// Screen row of the first row of d_buffer
+uint8_t d_band_top;
+#else
+//
+// GDRAM line shown at the top of each half of the screen, and whether the
+// controller has yet to be told
+uint8_t d_scroll;
+static bool _scroll_pending;
+#endif
+
+#if LCD_DOUBLE_BUFFER
+#if LCD_BAND_ROWS
+#error "LCD_DOUBLE_BUFFER needs the whole screen in d_buffer"
+#endif
+#if RAMEND < 0x10ff
+#error "LCD_DOUBLE_BUFFER needs 4K of RAM or more, as on the 1280 and 2560"
+#endif
+
+//
+// What the display is showing, as last sent
+uint8_t d_front[LCD_BUFFER_SIZE];
+
+//
+// Lines at the bottom of each half of the screen scrolled onto GDRAM which
+// d_front doesn't describe, so display_swap() must send them whole
+static uint8_t _scroll_stale;
+#endif
+
+#if LCD_GRAY_ROWS
+#if LCD_BAND_ROWS
+#error "LCD_GRAY_ROWS needs the whole screen in d_buffer"
+#endif
+#if LCD_DOUBLE_BUFFER
+#error "LCD_GRAY_ROWS can't be used with LCD_DOUBLE_BUFFER"
+#endif
+#if LCD_GRAY_ROWS > LCD_HEIGHT
+#error "LCD_GRAY_ROWS must be at most LCD_HEIGHT"
+#endif
+#if LCD_BUFFER_SIZE + LCD_GRAY_ROWS * LCD_ROW_BYTES > (RAMEND - 0xff) * 3 / 4
+#error "LCD_GRAY_ROWS leaves too little RAM, use fewer rows"
+#endif
+
+//
+// Low bitplane of the gray rows
+uint8_t d_gray[LCD_GRAY_ROWS * LCD_ROW_BYTES];
+#endif
+
+//
+// Switch the controller to extended instructions with graphics display on
+static void _graphics_mode() {
+    lcd_instruction(0b00110100); // 8bit data, extended instructions
+    lcd_instruction(0b00110110); // +graphics
+}
+
+//
+// Point the GDRAM address counter at word 0-15 of the GDRAM line showing
+// screen line v
+static void _gdram_address(uint8_t v, uint8_t word) {
+#if !LCD_BAND_ROWS
+    v = (v + d_scroll) & 63;
+#endif
+    lcd_instruction(0b10000000 | v);
+    lcd_instruction(0b10000000 | word);
+}
+
+#if !LCD_BAND_ROWS
+//
+// Offset in d_buffer of word 0-15 of GDRAM line v
+static uint16_t _offset(uint8_t v, uint8_t word) {
+#if LCD_GDRAM_FOLD
+    if (word >= LCD_ROW_WORDS) {
+        v += LCD_GDRAM_LINES;
+        word -= LCD_ROW_WORDS;
+    }
+#endif
+    return v * LCD_ROW_BYTES + word * 2;
+}
+
+//
+// Dirty words of GDRAM line v, bit 0 being word 0
+static uint16_t _line_dirty(uint8_t v) {
+#if LCD_GDRAM_FOLD
+    return d_dirty[v] | (d_dirty[v + LCD_GDRAM_LINES] << LCD_ROW_WORDS);
+#else
+    return d_dirty[v];
+#endif
+}
+
+static void _line_clean(uint8_t v) {
+    d_dirty[v] = 0;
+#if LCD_GDRAM_FOLD
+    d_dirty[v + LCD_GDRAM_LINES] = 0;
+#endif
+}
+#endif
+
+//
+// Shrink w and h to keep a rectangle at x, y on the screen and in
+// d_buffer, and change y from a screen row to a d_buffer row.
+// Returns false if none of it is in d_buffer.
+static bool _clip(uint8_t x, uint8_t *y, uint8_t *w, uint8_t *h) {
+#if LCD_BAND_ROWS
+    int top = *y - d_band_top;
+    int bottom = top + *h;
+    if (top < 0) {
+        top = 0;
+    }
+    if (bottom > LCD_BAND_ROWS) {
+        bottom = LCD_BAND_ROWS;
+    }
+    if (x >= LCD_WIDTH || !*w || top >= bottom) {
+        return false;
+    }
+    *y = top;
+    *h = bottom - top;
+#else
+    if (x >= LCD_WIDTH || *y >= LCD_HEIGHT || !*w || !*h) {
+        return false;
+    }
+    if (*h > LCD_HEIGHT - *y) {
+        *h = LCD_HEIGHT - *y;
+    }
+#endif
+    if (*w > LCD_WIDTH - x) {
+        *w = LCD_WIDTH - x;
+    }
+    return true;
+}
+
+lcd_dirty_t display_span_mask(uint8_t x0, uint8_t x1) {
+    return (LCD_DIRTY_ALL << (x0 >> 4))
+            & (LCD_DIRTY_ALL >> (LCD_ROW_WORDS - 1 - (x1 >> 4)));
+}
+
+//
+// Bits of a d_dirty entry for the words holding pixels x to x + w - 1
+static lcd_dirty_t _word_mask(uint8_t x, uint8_t w) {
+    return display_span_mask(x, x + w - 1);
+}
+
+//
+// Mark a rectangle dirty, given in d_buffer rows and already clipped
+static void _mark(uint8_t x, uint8_t y, uint8_t w, uint8_t h) {
+    lcd_dirty_t mask = _word_mask(x, w);
+    for (lcd_dirty_t *d = d_dirty + y; h; h--, d++) {
+        *d |= mask;
+    }
+}
+
+//
+// Planning the transfer
+//
+// GDRAM vertical address v holds up to 16 words: on a folded panel row v
+// then row v + 32, otherwise row v alone. The address counter steps
+// through them after each word, so a line is sent with one address set
+// and then only data.
+//
+// Within a line the words to send are separated by gaps of words which
+// have not changed. Each gap can be skipped with a new address set, or
+// written through by sending the unchanged words again. The cheaper is
+// chosen using the modeled time of each transfer: two bytes at a
+// microsecond each, plus the controller's settle time. Each run of words
+// is sent as one data block, so its sync byte is not counted per word.
+#if LCD_TIMING == LCD_TIMING_TABLE
+#define COST_ADDRESS (2 * (3 + LCD_ADDRESS_US))
+#define COST_WORD (2 * (2 + LCD_DATA_US))
+#else
+#define COST_ADDRESS (2 * (3 + 72))
+#define COST_WORD (2 * (2 + 40))
+#endif
+
+// Words in a GDRAM line, and a mask of all of them
+#if LCD_GDRAM_FOLD
+#define LINE_WORDS (2 * LCD_ROW_WORDS)
+#else
+#define LINE_WORDS LCD_ROW_WORDS
+#endif
+#define LINE_ALL ((uint16_t) ((1UL << LINE_WORDS) - 1))
+
+display_stats_t display_stats;
+
+#if !LCD_BAND_ROWS
+//
+// Tell the controller the scroll position, if it has changed. This comes
+// after the lines scrolling in have been sent, which on a folded panel
+// keeps them out of sight until they hold the new pixels.
+static void _send_scroll() {
+    if (!_scroll_pending) {
+        return;
+    }
+    lcd_instruction(0b00000011); // vertical scroll address select
+    lcd_instruction(0b01000000 | d_scroll);
+    display_stats.sent += 6;
+    _scroll_pending = false;
+#if LCD_DOUBLE_BUFFER
+    _scroll_stale = 0;
+#endif
+}
+
+//
+// Address word 0-15 of vertical address v and send 'count' words from
+// there. On a folded panel the two rows of a line are apart in d_buffer,
+// so a run over the middle of the line is sent as two blocks.
+static void _send_words(uint8_t v, uint8_t word, uint8_t count) {
+    _gdram_address(v, word);
+    display_stats.sent += 6;
+    while (count) {
+        uint8_t n = count;
+#if LCD_GDRAM_FOLD
+        if (word < LCD_ROW_WORDS && word + n > LCD_ROW_WORDS) {
+            n = LCD_ROW_WORDS - word;
+        }
+#endif
+        uint16_t offset = _offset(v, word);
+        lcd_data_block(d_buffer + offset, n * 2);
+#if LCD_DOUBLE_BUFFER
+        memcpy(d_front + offset, d_buffer + offset, n * 2);
+#endif
+        display_stats.sent += 1 + n * 4;
+        word += n;
+        count -= n;
+    }
+}
+
+//
+// Send the words of vertical address v which are set in mask, bit 0 being
+// word 0
+static void _send_line(uint8_t v, uint16_t mask) {
+    uint8_t word = 0;
+    // First word of the run being built, or -1 if none
+    int8_t start = -1;
+    while (mask) {
+        if (mask & 1) {
+            if (start < 0) {
+                start = word;
+            }
+            mask >>= 1;
+            word++;
+            continue;
+        }
+        // Length of the gap before the next word to send
+        uint8_t gap = 0;
+        while (!(mask & 1)) {
+            mask >>= 1;
+            gap++;
+        }
+        if (start >= 0 && gap * COST_WORD > COST_ADDRESS) {
+            // Cheaper to end the run and address the next one
+            _send_words(v, start, word - start);
+            start = -1;
+        }
+        word += gap;
+    }
+    if (start >= 0) {
+        _send_words(v, start, word - start);
+    }
+}
 
 //
 // Call this to paint the d_buffer ram onto the d_buffer
 // Display will then be in graphics mode. Call lcd_reset() to go back to text mode
 void display_refresh() {
-    // Initialize graphics mode
-    lcd_instruction(0b00110100); // 8bit data, extended instructions
-    lcd_instruction(0b00110110); // +graphics
+    _graphics_mode();
+    display_stats.sent += 6;
+    display_stats.naive += LCD_NAIVE_BYTES;
+
+    for (uint8_t v = 0; v < LCD_GDRAM_LINES; v++) {
+        _send_line(v, LINE_ALL);
+    }
+    memset(d_dirty, 0, sizeof(d_dirty));
+    // The controller may have been reset since
+    _scroll_pending |= d_scroll != 0;
+    _send_scroll();
+}
+
+//
+// Paint only the d_buffer words marked in d_dirty, then clear the marks.
+void display_refresh_dirty() {
+    _graphics_mode();
+    display_stats.sent += 6;
+    display_stats.naive += LCD_NAIVE_BYTES;
+
+    for (uint8_t v = 0; v < LCD_GDRAM_LINES; v++) {
+        uint16_t mask = _line_dirty(v);
+        if (mask) {
+            _line_clean(v);
+            _send_line(v, mask);
+        }
+    }
+    _send_scroll();
+}
+
+//
+// Paint the words covering a rectangle of d_buffer, whether dirty or not.
+void display_refresh_rect(uint8_t x, uint8_t y, uint8_t w, uint8_t h) {
+    if (!_clip(x, &y, &w, &h)) {
+        return;
+    }
+    _graphics_mode();
+    display_stats.sent += 6;
+    display_stats.naive += LCD_NAIVE_BYTES;
+
+    lcd_dirty_t words = _word_mask(x, w);
+    uint8_t end = y + h;
+    for (uint8_t v = 0; v < LCD_GDRAM_LINES; v++) {
+        uint16_t mask = 0;
+        if (v >= y && v < end) {
+            mask = words;
+            d_dirty[v] &= ~words;
+        }
+#if LCD_GDRAM_FOLD
+        uint8_t row = v + LCD_GDRAM_LINES;
+        if (row >= y && row < end) {
+            mask |= words << LCD_ROW_WORDS;
+            d_dirty[row] &= ~words;
+        }
+#endif
+        if (mask) {
+            _send_line(v, mask);
+        }
+    }
+    // Any pending scroll waits for a refresh that sends the lines it
+    // brings into view
+}
+
+#if LCD_DOUBLE_BUFFER
+//
+// Send the words of d_buffer which differ from d_front, and copy them
+// across. Only words marked dirty are compared.
+void display_swap() {
+    _graphics_mode();
+    display_stats.sent += 6;
+    display_stats.naive += LCD_NAIVE_BYTES;
+
+    for (uint8_t v = 0; v < LCD_GDRAM_LINES; v++) {
+        uint16_t dirty = _line_dirty(v);
+        if (!dirty) {
+            continue;
+        }
+        _line_clean(v);
+        if (v >= LCD_GDRAM_LINES - _scroll_stale) {
+            _send_line(v, dirty);
+            continue;
+        }
+        uint16_t mask = 0;
+        for (uint8_t word = 0; word < LINE_WORDS; word++) {
+            uint16_t offset = _offset(v, word);
+            if ((dirty & (1U << word))
+                    && (d_buffer[offset] != d_front[offset]
+                            || d_buffer[offset + 1] != d_front[offset + 1])) {
+                mask |= 1U << word;
+            }
+        }
+        _send_line(v, mask);
+    }
+    _send_scroll();
+}
+#endif
+
+//
+// Scroll the picture up. The controller does the moving, and only the
+// GDRAM lines which come into view need sending.
+//
+// The controller scrolls a ring of 64 GDRAM lines, and the screen, or each
+// half of a folded panel, is a window of LCD_GDRAM_LINES onto it. Where
+// the window is shorter than the ring, as on a folded panel or a 32 row
+// one, the lines scrolling into the bottom are ones that were off the
+// screen. Where it is all 64 lines, they are those that left the top.
+// Either way the bottom 'rows' lines of each window hold the wrong pixels,
+// and are marked to be sent whole.
+void display_scroll(uint8_t rows) {
+    if (rows > LCD_HEIGHT) {
+        rows = LCD_HEIGHT;
+    }
+    uint16_t kept = (LCD_HEIGHT - rows) * LCD_ROW_BYTES;
+    memmove(d_buffer, d_buffer + rows * LCD_ROW_BYTES, kept);
+    memset(d_buffer + kept, 0, rows * LCD_ROW_BYTES);
+    memmove(d_dirty, d_dirty + rows, (LCD_HEIGHT - rows) * sizeof(d_dirty[0]));
+    memset(d_dirty + LCD_HEIGHT - rows, 0, rows * sizeof(d_dirty[0]));
+
+    uint8_t stale = rows < LCD_GDRAM_LINES ? rows : LCD_GDRAM_LINES;
+#if LCD_DOUBLE_BUFFER
+    memmove(d_front, d_front + rows * LCD_ROW_BYTES, kept);
+    _scroll_stale = _scroll_stale + stale < LCD_GDRAM_LINES
+            ? _scroll_stale + stale : LCD_GDRAM_LINES;
+#endif
+    for (uint8_t y = 0; y < LCD_HEIGHT; y++) {
+        if (y % LCD_GDRAM_LINES >= LCD_GDRAM_LINES - stale) {
+            d_dirty[y] = LCD_DIRTY_ALL;
+        }
+    }
+    d_scroll = (d_scroll + rows) & 63;
+    _scroll_pending = true;
+}
+#else
+//
+// Send the rows of the band. Each row needs its own address, as on a
+// folded panel the two halves of a GDRAM line are in different bands.
+static void _send_band(uint8_t rows) {
+    const uint8_t *p = d_buffer;
+    for (uint8_t r = 0; r < rows; r++, p += LCD_ROW_BYTES) {
+        uint8_t row = d_band_top + r;
+        _gdram_address(row % LCD_GDRAM_LINES,
+                row < LCD_GDRAM_LINES ? 0 : LCD_ROW_WORDS);
+        lcd_data_block(p, LCD_ROW_BYTES);
+        display_stats.sent += 6 + 1 + LCD_ROW_BYTES * 2;
+    }
+}
+
+void display_render(void (*draw)()) {
+    _graphics_mode();
+    display_stats.sent += 6;
+    display_stats.naive += LCD_NAIVE_BYTES;
+
+    for (d_band_top = 0; d_band_top < LCD_HEIGHT;
+            d_band_top += LCD_BAND_ROWS) {
+        memset(d_buffer, 0, sizeof(d_buffer));
+        if (draw) {
+            draw();
+        }
+        uint8_t rows = LCD_HEIGHT - d_band_top;
+        _send_band(rows < LCD_BAND_ROWS ? rows : LCD_BAND_ROWS);
+    }
+    d_band_top = 0;
+    memset(d_dirty, 0, sizeof(d_dirty));
+}
+#endif
 
-    uint8_t *p = d_buffer;
-    for (int row = 0; row < 64; row++) {
-        // To Start of Row
-        lcd_instruction(0b10000000 | (row & 0x1f));
-        lcd_instruction(row < 32 ? 0b10000000 : 0b10001000);
-        // Iterate over bytes
-        for (int j = 0; j < 16; j++) {
-            lcd_data(*p);
-            p++;
+//
+// Mark the whole d_buffer as needing to be sent
+void display_invalidate() {
+    for (uint8_t row = 0; row < LCD_BUFFER_ROWS; row++) {
+        d_dirty[row] = LCD_DIRTY_ALL;
+    }
+}
+
+//
+// Clear the first rows of d_buffer, or of a plane laid out like it,
+// marking the words which were not already empty
+static void _clear_rows(uint8_t *p, uint8_t rows) {
+    for (uint8_t row = 0; row < rows; row++) {
+        lcd_dirty_t dirty = 0;
+        for (uint8_t word = 0; word < LCD_ROW_WORDS; word++) {
+            if (p[0] | p[1]) {
+                p[0] = 0;
+                p[1] = 0;
+                dirty |= (lcd_dirty_t) 1 << word;
+            }
+            p += 2;
         }
+        d_dirty[row] |= dirty;
     }
 }
 
 //
-// Clear d_buffer to empty
+// Clear d_buffer to empty. Only words which were not already empty are
+// marked dirty, so a clear and redraw re-sends just the old and new
+// drawing.
 void display_clear() {
-    memset(d_buffer, 0, 1024);
+    _clear_rows(d_buffer, LCD_BUFFER_ROWS);
+#if LCD_GRAY_ROWS
+    _clear_rows(d_gray, LCD_GRAY_ROWS);
+#endif
 }
 
 //
 // Set a bit on the d_buffer
-// 0 <= x < 128, 0 <= y < 64
+// 0 <= x < LCD_WIDTH, 0 <= y < LCD_HEIGHT
 void display_set(uint8_t x, uint8_t y) {
-    uint8_t *addr = d_buffer + (y * 16) + ((x & 0x78) >> 3);
+#if LCD_BAND_ROWS
+    y -= d_band_top;
+    if (y >= LCD_BAND_ROWS) {
+        return;
+    }
+#endif
+    uint8_t *addr = d_buffer + (y * LCD_ROW_BYTES) + (x >> 3);
     *addr = (*addr) | (0x80 >> (x & 7));
+    d_dirty[y] |= (lcd_dirty_t) 1 << (x >> 4);
+}
+
+//
+// Mark a rectangle of d_buffer dirty, clipped to the screen
+void display_mark_dirty(uint8_t x, uint8_t y, uint8_t w, uint8_t h) {
+    if (_clip(x, &y, &w, &h)) {
+        _mark(x, y, w, h);
+    }
+}
+
+// Masks for the first and last bytes of a span, indexed by x & 7 of the
+// first pixel and of the pixel after the last
+static const uint8_t _left_mask[8] PROGMEM = {
+        0xff, 0x7f, 0x3f, 0x1f, 0x0f, 0x07, 0x03, 0x01 };
+static const uint8_t _right_mask[8] PROGMEM = {
+        0xff, 0x80, 0xc0, 0xe0, 0xf0, 0xf8, 0xfc, 0xfe };
+
+//
+// Set or clear a rectangle of d_buffer, or of a plane laid out like it.
+// Whole bytes are stored directly, and only the bytes at each end of a row
+// are masked.
+static void _fill(uint8_t *buffer, uint8_t x, uint8_t y, uint8_t w,
+        uint8_t h, bool set) {
+    if (!_clip(x, &y, &w, &h)) {
+        return;
+    }
+    _mark(x, y, w, h);
+
+    uint8_t first = x >> 3;
+    uint8_t last = (x + w - 1) >> 3;
+    uint8_t left = pgm_read_byte(&_left_mask[x & 7]);
+    uint8_t right = pgm_read_byte(&_right_mask[(x + w) & 7]);
+    uint8_t fill = set ? 0xff : 0x00;
+    if (first == last) {
+        left &= right;
+    }
+    uint8_t *p = buffer + y * LCD_ROW_BYTES + first;
+    for (; h; h--, p += LCD_ROW_BYTES) {
+        if (set) {
+            p[0] |= left;
+        } else {
+            p[0] &= ~left;
+        }
+        if (first != last) {
+            memset(p + 1, fill, last - first - 1);
+            if (set) {
+                p[last - first] |= right;
+            } else {
+                p[last - first] &= ~right;
+            }
+        }
+    }
+}
+
+//
+// Set pixels x0 to x1 inclusive in row y. All must be on the screen.
+void display_span(uint8_t x0, uint8_t x1, uint8_t y) {
+#if LCD_BAND_ROWS
+    y -= d_band_top;
+    if (y >= LCD_BAND_ROWS) {
+        return;
+    }
+#endif
+    uint8_t *p = d_buffer + y * LCD_ROW_BYTES + (x0 >> 3);
+    uint8_t *last = d_buffer + y * LCD_ROW_BYTES + (x1 >> 3);
+    uint8_t left = pgm_read_byte(&_left_mask[x0 & 7]);
+    uint8_t right = pgm_read_byte(&_right_mask[(x1 + 1) & 7]);
+    if (p == last) {
+        *p |= left & right;
+    } else {
+        *p++ |= left;
+        while (p < last) {
+            *p++ = 0xff;
+        }
+        *p |= right;
+    }
+    d_dirty[y] |= display_span_mask(x0, x1);
+}
+
+//
+// Horizontal and vertical lines, clipped to the screen
+void display_hline(uint8_t x, uint8_t y, uint8_t w) {
+    _fill(d_buffer, x, y, w, 1, true);
+}
+
+void display_vline(uint8_t x, uint8_t y, uint8_t h) {
+    _fill(d_buffer, x, y, 1, h, true);
+}
+
+//
+// Set or clear every pixel in a rectangle, clipped to the screen
+void display_fill_rect(uint8_t x, uint8_t y, uint8_t w, uint8_t h) {
+    _fill(d_buffer, x, y, w, h, true);
+}
+
+void display_clear_rect(uint8_t x, uint8_t y, uint8_t w, uint8_t h) {
+    _fill(d_buffer, x, y, w, h, false);
+}
+
+#if LCD_GRAY_ROWS
+void display_fill_shade(uint8_t x, uint8_t y, uint8_t w, uint8_t h,
+        uint8_t shade) {
+    _fill(d_buffer, x, y, w, h, shade & 2);
+    if (y < LCD_GRAY_ROWS) {
+        if (h > LCD_GRAY_ROWS - y) {
+            h = LCD_GRAY_ROWS - y;
+        }
+        _fill(d_gray, x, y, w, h, shade & 1);
+    }
+}
+
+void display_shade(uint8_t x, uint8_t y, uint8_t shade) {
+    display_fill_shade(x, y, 1, 1, shade);
 }
+#endif
 
 //
 // A version of display_set that checks bounds
 void display_set_check(int x, int y) {
-    if (x < 0 || x >= 128 || y < 0 || y >= 64) {
+    if (x < 0 || x >= LCD_WIDTH || y < 0 || y >= LCD_HEIGHT) {
         return;
     }
     display_set(x, y);
 }
 
+// Cohen-Sutherland outcodes, for which side of the screen a point is off
+#define OUT_LEFT 1
+#define OUT_RIGHT 2
+#define OUT_TOP 4
+#define OUT_BOTTOM 8
+
+static uint8_t _outcode(int x, int y) {
+    uint8_t code = 0;
+    if (x < 0) {
+        code |= OUT_LEFT;
+    } else if (x > LCD_WIDTH - 1) {
+        code |= OUT_RIGHT;
+    }
+    if (y < 0) {
+        code |= OUT_TOP;
+    } else if (y > LCD_HEIGHT - 1) {
+        code |= OUT_BOTTOM;
+    }
+    return code;
+}
+
+//
+// Clip a line to the screen with the Cohen-Sutherland algorithm.
+// Returns false if none of the line is on the screen.
+static bool _clip_line(int *x0, int *y0, int *x1, int *y1) {
+    uint8_t code0 = _outcode(*x0, *y0);
+    uint8_t code1 = _outcode(*x1, *y1);
+    for (;;) {
+        if (!(code0 | code1)) {
+            return true;
+        }
+        if (code0 & code1) {
+            return false;
+        }
+        // Move the outside end to the edge it is beyond
+        uint8_t code = code0 ? code0 : code1;
+        long dx = *x1 - *x0;
+        long dy = *y1 - *y0;
+        int x, y;
+        if (code & OUT_BOTTOM) {
+            y = LCD_HEIGHT - 1;
+            x = *x0 + dx * (LCD_HEIGHT - 1 - *y0) / dy;
+        } else if (code & OUT_TOP) {
+            y = 0;
+            x = *x0 - dx * *y0 / dy;
+        } else if (code & OUT_RIGHT) {
+            x = LCD_WIDTH - 1;
+            y = *y0 + dy * (LCD_WIDTH - 1 - *x0) / dx;
+        } else {
+            x = 0;
+            y = *y0 - dy * *x0 / dx;
+        }
+        if (code == code0) {
+            *x0 = x;
+            *y0 = y;
+            code0 = _outcode(x, y);
+        } else {
+            *x1 = x;
+            *y1 = y;
+            code1 = _outcode(x, y);
+        }
+    }
+}
+
 //
 // Draw a line with Bresenhan's algorithm
 // http://en.wikipedia.org/wiki/Bresenham's_line_algorithm
-void display_line(uint8_t x0, uint8_t y0, uint8_t x1, uint8_t y1) {
-    bool steep = abs(y1 - y0) > abs(x1 - x0);
-#define swap(a, b) {uint8_t c = a; a = b; b = c;}
-    if (steep) {
-        swap(x0, y0);
-        swap(x1, y1);
+//
+// Horizontal and vertical lines are rectangle fills. Other shallow lines
+// are drawn as one horizontal span per row. Steep lines step a pointer
+// and mask through d_buffer rather than recomputing each address.
+void display_line(int x0, int y0, int x1, int y1) {
+    if (!_clip_line(&x0, &y0, &x1, &y1)) {
+        return;
     }
-    if (x0 > x1) {
-        swap(x0, x1);
-        swap(y0, y1);
+#if LCD_BAND_ROWS
+    // Skip lines wholly above or below the band
+    int bottom = d_band_top + LCD_BAND_ROWS;
+    if ((y0 < d_band_top && y1 < d_band_top)
+            || (y0 >= bottom && y1 >= bottom)) {
+        return;
     }
-#undef swap
-    int deltax = x1 - x0;
+#endif
+#define swap(a, b) {int c = a; a = b; b = c;}
+    int deltax = abs(x1 - x0);
     int deltay = abs(y1 - y0);
-    int error = deltax >> 1; // deltax/2
-    int8_t ystep = (y0 < y1) ? 1 : -1;
-    uint8_t y = y0;
-    for (uint8_t x = x0; x != x1; x++) {
-        if (steep) {
-            display_set(y, x);
-        } else {
-            display_set(x, y);
+    if (deltax >= deltay) {
+        if (x0 > x1) {
+            swap(x0, x1);
+            swap(y0, y1);
+        }
+        if (!deltay) {
+            display_span(x0, x1, y0);
+            return;
+        }
+        int error = deltax >> 1; // deltax/2
+        int8_t ystep = (y0 < y1) ? 1 : -1;
+        uint8_t y = y0;
+        uint8_t start = x0;
+        for (uint8_t x = x0; x < x1; x++) {
+            error = error - deltay;
+            if (error < 0) {
+                // End of this row's span
+                display_span(start, x, y);
+                start = x + 1;
+                y += ystep;
+                error += deltax;
+            }
+        }
+        display_span(start, x1, y);
+    } else {
+        if (y0 > y1) {
+            swap(x0, x1);
+            swap(y0, y1);
+        }
+        if (!deltax) {
+            _fill(d_buffer, x0, y0, 1, deltay + 1, true);
+            return;
+        }
+        int error = deltay >> 1; // deltay/2
+        bool right = x0 < x1;
+        uint8_t x = x0;
+        uint8_t y = y0;
+#if LCD_BAND_ROWS
+        // Step down to the band without drawing, and stop at its bottom
+        for (; y < d_band_top; y++) {
+            error = error - deltax;
+            if (error < 0) {
+                x += right ? 1 : -1;
+                error += deltay;
+            }
+        }
+        if (y1 >= bottom) {
+            y1 = bottom - 1;
         }
-        error = error - deltay;
-        if (error < 0) {
-            y += ystep;
-            error += deltax;
+#endif
+        uint8_t *p = d_buffer + ((y - LCD_BUFFER_TOP) * LCD_ROW_BYTES)
+                + (x >> 3);
+        uint8_t mask = 0x80 >> (x & 7);
+        for (;; y++) {
+            *p |= mask;
+            d_dirty[y - LCD_BUFFER_TOP] |= (lcd_dirty_t) 1 << (x >> 4);
+            if (y == y1) {
+                break;
+            }
+            p += LCD_ROW_BYTES;
+            error = error - deltax;
+            if (error < 0) {
+                if (right) {
+                    x++;
+                    mask >>= 1;
+                    if (!mask) {
+                        mask = 0x80;
+                        p++;
+                    }
+                } else {
+                    x--;
+                    mask <<= 1;
+                    if (!mask) {
+                        mask = 0x01;
+                        p--;
+                    }
+                }
+                error += deltay;
+            }
         }
     }
+#undef swap
 }
 
 // An implementation of the midpoint circle algorithm
 // http://en.wikipedia.org/wiki/Midpoint_circle_algorithm
 // 'cx' and 'cy' denote the offset of the circle centre from the origin.
-static void _plot4points(int cx, int cy, int x, int y) {
-    display_set_check(cx + x, cy + y);
-    display_set_check(cx - x, cy + y);
-    display_set_check(cx + x, cy - y);
-    display_set_check(cx - x, cy - y);
+//
+// Each of the eight octants is checked against the screen (or band) once,
+// before drawing. Points of octants wholly on it are set without bounds
+// checks, and octants wholly off it are skipped.
+#define OCTANT_OFF 0
+#define OCTANT_ON 1
+#define OCTANT_PART 2
+
+static uint8_t _range(long lo, long hi, int size) {
+    if (hi < 0 || lo >= size) {
+        return OCTANT_OFF;
+    }
+    return lo >= 0 && hi < size ? OCTANT_ON : OCTANT_PART;
+}
+
+static void _plot(int x, int y, uint8_t mode) {
+    if (mode == OCTANT_ON) {
+        display_set(x, y);
+    } else if (mode == OCTANT_PART) {
+        display_set_check(x, y);
+    }
+}
+
+// Octants 0-3 are (x, y), 4-7 are (y, x). Odd octants negate the first
+// coordinate and octants 2, 3, 6 and 7 negate the second.
+static void _plot4points(int cx, int cy, int x, int y, const uint8_t *mode) {
+    _plot(cx + x, cy + y, mode[0]);
+    _plot(cx - x, cy + y, mode[1]);
+    _plot(cx + x, cy - y, mode[2]);
+    _plot(cx - x, cy - y, mode[3]);
 }
 
-static void _plot8points(int cx, int cy, int x, int y) {
-    _plot4points(cx, cy, x, y);
-    _plot4points(cx, cy, y, x);
+static void _plot8points(int cx, int cy, int x, int y, const uint8_t *mode) {
+    _plot4points(cx, cy, x, y, mode);
+    _plot4points(cx, cy, y, x, mode + 4);
 }
 
-void display_circle(uint8_t cx, uint8_t cy, uint8_t radius) {
+void display_circle(int cx, int cy, uint8_t radius) {
+    // Octant points run from (radius, 0) to about (diag, diag)
+    // radius / sqrt(2). The product can pass 32767, so it is unsigned.
+    int diag = ((uint16_t) radius * 181) >> 8;
+    uint8_t mode[8];
+    bool any = false;
+    for (uint8_t o = 0; o < 8; o++) {
+        int x0 = diag > 2 ? diag - 2 : 0, x1 = radius;
+        int y0 = 0, y1 = diag + 2;
+        if (o & 4) {
+            int t = x0;
+            x0 = y0;
+            y0 = t;
+            t = x1;
+            x1 = y1;
+            y1 = t;
+        }
+        if (o & 1) {
+            int t = x0;
+            x0 = -x1;
+            x1 = -t;
+        }
+        if (o & 2) {
+            int t = y0;
+            y0 = -y1;
+            y1 = -t;
+        }
+        // In long, so a centre far off the screen can't wrap round onto it
+        uint8_t mx = _range((long) cx + x0, (long) cx + x1, LCD_WIDTH);
+        uint8_t my = _range((long) cy + y0 - LCD_BUFFER_TOP,
+                (long) cy + y1 - LCD_BUFFER_TOP, LCD_BUFFER_ROWS);
+        if (mx == OCTANT_OFF || my == OCTANT_OFF) {
+            mode[o] = OCTANT_OFF;
+        } else {
+            mode[o] = mx == OCTANT_ON && my == OCTANT_ON ? OCTANT_ON
+                    : OCTANT_PART;
+            any = true;
+        }
+    }
+    if (!any) {
+        return;
+    }
+
     int error = -radius;
     int x = radius;
     int y = 0;
 
     while (x > y) {
-        _plot8points(cx, cy, x, y);
+        _plot8points(cx, cy, x, y, mode);
         error += y;
         ++y;
         error += y;
@@ -134,6 +904,5 @@ void display_circle(uint8_t cx, uint8_t cy, uint8_t radius) {
             error -= x;
         }
     }
-    _plot4points(cx, cy, x, y);
+    _plot4points(cx, cy, x, y, mode);
 }
-
@@ -0,0 +1,144 @@
+/*
+ * lcd_image.c
+ *
+ * LCD Library compressed images.
+ *
+ * An image in PROGMEM is two bytes, the bytes in each row and the number
+ * of rows, then its rows laid out as for display_blit_p() and packed with
+ * PackBits. Each run starts with a count byte n: 0 to 127 means n + 1
+ * bytes follow as they are, 129 to 255 means the next byte is repeated
+ * 257 - n times, and 128 is skipped. Runs may carry on from one row to
+ * the next. lcdhost/imgconv.c makes images from PBM files.
+ *
+ * An image can be unpacked into d_buffer, or sent straight to GDRAM a
+ * line at a time without using d_buffer at all.
+ */
+
+#include <avr/io.h>
+#include <avr/pgmspace.h>
+#include <inttypes.h>
+#include <stdbool.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "lcd.h"
+
+typedef struct {
+    const uint8_t *p; // next byte of the packed data
+    uint8_t count; // bytes left in this run
+    bool repeat; // run is of one byte repeated
+    uint8_t value; // the byte repeated
+} _unpack_t;
+
+static uint8_t _next(_unpack_t *u) {
+    while (!u->count) {
+        uint8_t n = pgm_read_byte(u->p++);
+        if (n < 128) {
+            u->count = n + 1;
+            u->repeat = false;
+        } else if (n > 128) {
+            u->count = 257 - n;
+            u->repeat = true;
+            u->value = pgm_read_byte(u->p++);
+        }
+    }
+    u->count--;
+    return u->repeat ? u->value : pgm_read_byte(u->p++);
+}
+
+void display_image_p(const uint8_t *image, int x, int y) {
+    uint8_t stride = pgm_read_byte(image);
+    uint8_t rows = pgm_read_byte(image + 1);
+    _unpack_t u = { image + 2 };
+
+    // Byte columns and words of the screen covered
+    int col = x >> 3;
+    int first = col < 0 ? 0 : col;
+    int last = col + stride > LCD_ROW_BYTES ? LCD_ROW_BYTES - 1
+            : col + stride - 1;
+    lcd_dirty_t mask = 0;
+    if (first <= last) {
+        mask = display_span_mask(first * 8, last * 8 + 7);
+    }
+
+    // From here on y is a row of d_buffer
+    y -= LCD_BUFFER_TOP;
+    for (uint8_t r = 0; r < rows; r++, y++) {
+        if (y >= LCD_BUFFER_ROWS) {
+            break;
+        }
+        uint8_t *p = d_buffer + y * LCD_ROW_BYTES;
+        for (uint8_t i = 0; i < stride; i++) {
+            uint8_t b = _next(&u);
+            int c = col + i;
+            if (y >= 0 && c >= first && c <= last) {
+                p[c] = b;
+            }
+        }
+        if (y >= 0) {
+            d_dirty[y] |= mask;
+        }
+    }
+}
+
+//
+// Unpack the next row of an image into row, keeping what fits on the
+// screen
+static void _unpack_row(_unpack_t *u, uint8_t *row, uint8_t stride) {
+    for (uint8_t i = 0; i < stride; i++) {
+        uint8_t b = _next(u);
+        if (i < LCD_ROW_BYTES) {
+            row[i] = b;
+        }
+    }
+}
+
+void lcd_image_p(const uint8_t *image) {
+    uint8_t stride = pgm_read_byte(image);
+    uint8_t rows = pgm_read_byte(image + 1);
+    _unpack_t top = { image + 2 };
+#if LCD_GDRAM_FOLD
+    // The bottom half of the screen is the right half of the GDRAM lines
+    // showing the top half, so is unpacked alongside it
+    _unpack_t bottom = top;
+    for (uint16_t i = stride * (rows < LCD_GDRAM_LINES ? rows
+            : LCD_GDRAM_LINES); i; i--) {
+        _next(&bottom);
+    }
+    uint8_t line[2 * LCD_ROW_BYTES];
+#else
+    uint8_t line[LCD_ROW_BYTES];
+#endif
+
+    lcd_instruction(0b00110100); // 8bit data, extended instructions
+    lcd_instruction(0b00110110); // +graphics
+    display_stats.sent += 6;
+    display_stats.naive += LCD_NAIVE_BYTES;
+    for (uint8_t v = 0; v < LCD_GDRAM_LINES; v++) {
+        memset(line, 0, sizeof(line));
+        if (v < rows) {
+            _unpack_row(&top, line, stride);
+        }
+#if LCD_GDRAM_FOLD
+        if (v + LCD_GDRAM_LINES < rows) {
+            _unpack_row(&bottom, line + LCD_ROW_BYTES, stride);
+        }
+#endif
+#if LCD_BAND_ROWS
+        lcd_instruction(0b10000000 | v);
+#else
+        lcd_instruction(0b10000000 | ((v + d_scroll) & 63));
+#endif
+        lcd_instruction(0b10000000); // word 0
+        lcd_data_block(line, sizeof(line));
+        display_stats.sent += 6 + 1 + sizeof(line) * 2;
+    }
+#if !LCD_BAND_ROWS
+    // Every line is now written for d_scroll, so set it as the refresh
+    // functions would, after the lines. A scroll still pending there
+    // sends it again, harmlessly.
+    lcd_instruction(0b00000011); // vertical scroll address select
+    lcd_instruction(0b01000000 | d_scroll);
+    display_stats.sent += 6;
+#endif
+}
@@ -0,0 +1,106 @@
+/*
+ * lcd_print.h
+ *
+ * Arduino Print sink for the text screen, for C++ programs built against
+ * Arduino10. print() and println() of numbers, floats and strings then
+ * work on the display as they do on Serial.
+ *
+ * Characters go into t_buffer at a cursor, wrapping at the end of each
+ * line and from the last line back to the first. A line is only wrapped
+ * when another character is written past its end, so a full line ended
+ * by println() moves down one line, not two. Nothing is sent until
+ * flush() or the end of a line, when lcd_text_flush() sends only the
+ * changed cells, several characters to a data block. The many small
+ * writes Print makes for one number cost no bus time of their own.
+ *
+ * Everything is inline here, so lcdlib itself needn't be built against
+ * Arduino.
+ */
+
+#ifndef LCD_PRINT_H_
+#define LCD_PRINT_H_
+
+#include <Print.h>
+#include <string.h>
+
+#include "lcd.h"
+
+class LcdPrint: public Print {
+public:
+    LcdPrint() :
+            line(0), col(0) {
+    }
+
+    // Blank the screen and note it as blank. Call after lcd_reset().
+    void begin() {
+        lcd_text_reset();
+        line = col = 0;
+    }
+
+    // Blank t_buffer, to be sent by the next flush, and home the cursor
+    void clear() {
+        lcd_text_clear();
+        line = col = 0;
+    }
+
+    // Line 0-3, character column 0-15
+    void setCursor(uint8_t l, uint8_t c) {
+        line = l < LCD_TEXT_LINES ? l : LCD_TEXT_LINES - 1;
+        col = c < LCD_TEXT_COLS ? c : LCD_TEXT_COLS - 1;
+    }
+
+    // Send whatever has changed
+    void flush() {
+        lcd_text_flush();
+    }
+
+    virtual size_t write(uint8_t c) {
+        return write(&c, 1);
+    }
+
+    // '\n' blanks the rest of the line, moves to the start of the next and
+    // flushes. '\r' is ignored, so println() ends a line once.
+    virtual size_t write(const uint8_t *buffer, size_t size) {
+        const uint8_t *end = buffer + size;
+        while (buffer < end) {
+            uint8_t c = *buffer;
+            if (c == '\r') {
+                buffer++;
+            } else if (c == '\n') {
+                memset(&t_buffer[line][col], ' ', LCD_TEXT_COLS - col);
+                next_line();
+                lcd_text_flush();
+                buffer++;
+            } else {
+                if (col == LCD_TEXT_COLS) {
+                    // Wrap pending from the last character
+                    next_line();
+                }
+                // Copy up to the end of the line or the next control
+                uint8_t n = 0;
+                while (col + n < LCD_TEXT_COLS && buffer + n < end
+                        && buffer[n] != '\r' && buffer[n] != '\n') {
+                    n++;
+                }
+                memcpy(&t_buffer[line][col], buffer, n);
+                buffer += n;
+                col += n;
+            }
+        }
+        return size;
+    }
+
+    using Print::write;
+
+private:
+    // col is LCD_TEXT_COLS after the last character of a line, until the
+    // next character wraps or a '\n' ends the line
+    uint8_t line, col;
+
+    void next_line() {
+        col = 0;
+        line = (line + 1) % LCD_TEXT_LINES;
+    }
+};
+
+#endif /* LCD_PRINT_H_ */
@@ -0,0 +1,371 @@
+/*
+ * lcd_scene.c
+ *
+ * LCD Library retained scene.
+ *
+ * The scene keeps a list of the shapes on the screen, not just their
+ * pixels. Adding, moving or removing an item damages the rectangles it
+ * covered and now covers. scene_update() clears only those rectangles of
+ * d_buffer and draws again only the items which overlap them, so
+ * changing a mostly still picture costs little drawing and little
+ * sending.
+ *
+ * Items are ORed together, so the order they are drawn in doesn't matter
+ * and drawing an item over its own pixels changes nothing. An item
+ * crossing the edge of the damage can then be drawn whole rather than
+ * clipped to it.
+ */
+
+#include <avr/io.h>
+#include <avr/pgmspace.h>
+#include <inttypes.h>
+#include <stdbool.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "lcd.h"
+
+#define KIND_FREE 0
+#define KIND_LINE 1
+#define KIND_CIRCLE 2
+#define KIND_RECT 3
+#define KIND_TEXT 4
+#define KIND_TEXT_P 5
+#define KIND_BITMAP 6
+
+typedef struct {
+    uint8_t kind;
+    int x, y; // first end of a line, centre, or top left
+    int a, b; // second end of a line, radius, or width and height
+    const void *data; // string or bitmap
+    const font_t *font;
+} _item_t;
+
+static _item_t _items[LCD_SCENE_ITEMS];
+
+//
+// Rectangle an item covers, inclusive, which may be off the screen.
+// Empty if x1 < x0.
+static void _bounds(const _item_t *i, int *x0, int *y0, int *x1, int *y1) {
+    switch (i->kind) {
+    case KIND_LINE:
+        *x0 = i->x < i->a ? i->x : i->a;
+        *x1 = i->x < i->a ? i->a : i->x;
+        *y0 = i->y < i->b ? i->y : i->b;
+        *y1 = i->y < i->b ? i->b : i->y;
+        break;
+    case KIND_CIRCLE:
+        *x0 = i->x - i->a;
+        *x1 = i->x + i->a;
+        *y0 = i->y - i->a;
+        *y1 = i->y + i->a;
+        break;
+    default:
+        *x0 = i->x;
+        *x1 = i->x + i->a - 1;
+        *y0 = i->y;
+        *y1 = i->y + i->b - 1;
+        break;
+    }
+}
+
+#if LCD_BAND_ROWS
+// The whole picture is drawn for every frame, so there is no damage to
+// keep track of
+#define _damage_item(i)
+#else
+//
+// Damaged rectangles, inclusive and on the screen. When there are more
+// than this, the two which grow least when joined are merged.
+#define DAMAGE_RECTS 4
+
+typedef struct {
+    uint8_t x0, y0, x1, y1;
+} _rect_t;
+
+static _rect_t _damage[DAMAGE_RECTS];
+static uint8_t _damage_count;
+
+static uint16_t _area(const _rect_t *r) {
+    return (r->x1 - r->x0 + 1) * (r->y1 - r->y0 + 1);
+}
+
+static void _join(_rect_t *r, const _rect_t *s) {
+    if (s->x0 < r->x0) {
+        r->x0 = s->x0;
+    }
+    if (s->y0 < r->y0) {
+        r->y0 = s->y0;
+    }
+    if (s->x1 > r->x1) {
+        r->x1 = s->x1;
+    }
+    if (s->y1 > r->y1) {
+        r->y1 = s->y1;
+    }
+}
+
+//
+// Damage an item's rectangle. A rectangle which can be joined with one
+// already damaged at no cost is, and otherwise it is added, or joined with
+// whichever grows least if there is no room.
+static void _damage_item(const _item_t *i) {
+    int x0, y0, x1, y1;
+    _bounds(i, &x0, &y0, &x1, &y1);
+    if (x1 < x0 || y1 < y0 || x1 < 0 || y1 < 0 || x0 >= LCD_WIDTH
+            || y0 >= LCD_HEIGHT) {
+        return;
+    }
+    _rect_t r = { x0 < 0 ? 0 : x0, y0 < 0 ? 0 : y0,
+            x1 >= LCD_WIDTH ? LCD_WIDTH - 1 : x1,
+            y1 >= LCD_HEIGHT ? LCD_HEIGHT - 1 : y1 };
+
+    uint8_t best = 0;
+    int32_t best_growth = INT32_MAX;
+    for (uint8_t d = 0; d < _damage_count; d++) {
+        _rect_t u = _damage[d];
+        _join(&u, &r);
+        int32_t growth = (int32_t) _area(&u) - _area(&_damage[d])
+                - _area(&r);
+        if (growth < best_growth) {
+            best = d;
+            best_growth = growth;
+        }
+    }
+    if (best_growth > 0 && _damage_count < DAMAGE_RECTS) {
+        _damage[_damage_count++] = r;
+    } else {
+        _join(&_damage[best], &r);
+    }
+}
+
+//
+// Clear a damaged rectangle of d_buffer, marking only the words which had
+// pixels set
+static void _erase(const _rect_t *r) {
+    uint8_t first = r->x0 >> 3;
+    uint8_t last = r->x1 >> 3;
+    uint8_t left = 0xff >> (r->x0 & 7);
+    uint8_t right = 0xff << (7 - (r->x1 & 7));
+    for (uint8_t y = r->y0; y <= r->y1; y++) {
+        uint8_t *row = d_buffer + y * LCD_ROW_BYTES;
+        lcd_dirty_t dirty = 0;
+        for (uint8_t b = first; b <= last; b++) {
+            uint8_t m = 0xff;
+            if (b == first) {
+                m &= left;
+            }
+            if (b == last) {
+                m &= right;
+            }
+            if (row[b] & m) {
+                row[b] &= ~m;
+                dirty |= (lcd_dirty_t) 1 << (b >> 1);
+            }
+        }
+        d_dirty[y] |= dirty;
+    }
+}
+
+//
+// True if an item overlaps any of the damage
+static bool _damaged(const _item_t *i) {
+    int x0, y0, x1, y1;
+    _bounds(i, &x0, &y0, &x1, &y1);
+    for (uint8_t d = 0; d < _damage_count; d++) {
+        const _rect_t *r = &_damage[d];
+        if (x0 <= r->x1 && x1 >= r->x0 && y0 <= r->y1 && y1 >= r->y0) {
+            return true;
+        }
+    }
+    return false;
+}
+#endif
+
+static void _draw(const _item_t *i) {
+    switch (i->kind) {
+    case KIND_LINE:
+        display_line(i->x, i->y, i->a, i->b);
+        break;
+    case KIND_CIRCLE:
+        display_circle(i->x, i->y, i->a);
+        break;
+    case KIND_RECT: {
+        // As spans, which unlike display_fill_rect() can be 256 wide
+        int x0, y0, x1, y1;
+        _bounds(i, &x0, &y0, &x1, &y1);
+        x0 = x0 < 0 ? 0 : x0;
+        y0 = y0 < 0 ? 0 : y0;
+        x1 = x1 >= LCD_WIDTH ? LCD_WIDTH - 1 : x1;
+        y1 = y1 >= LCD_HEIGHT ? LCD_HEIGHT - 1 : y1;
+        if (x0 <= x1) {
+            for (int y = y0; y <= y1; y++) {
+                display_span(x0, x1, y);
+            }
+        }
+        break;
+    }
+    case KIND_TEXT:
+        display_text(i->font, i->x, i->y, i->data, DISPLAY_OR);
+        break;
+    case KIND_TEXT_P:
+        display_text_p(i->font, i->x, i->y, i->data, DISPLAY_OR);
+        break;
+    case KIND_BITMAP:
+        display_blit_p(i->data, i->x, i->y, i->a, i->b, DISPLAY_OR);
+        break;
+    }
+}
+
+//
+// Size a text item to its string
+static void _measure(_item_t *i) {
+    if (i->kind == KIND_TEXT) {
+        i->a = display_text_width(i->font, i->data);
+    } else {
+        i->a = display_text_width_p(i->font, i->data);
+    }
+    i->b = pgm_read_byte(&i->font->height);
+}
+
+static uint8_t _add(uint8_t kind, int x, int y, int a, int b,
+        const void *data, const font_t *font) {
+    for (uint8_t id = 0; id < LCD_SCENE_ITEMS; id++) {
+        _item_t *i = &_items[id];
+        if (i->kind == KIND_FREE) {
+            i->kind = kind;
+            i->x = x;
+            i->y = y;
+            i->a = a;
+            i->b = b;
+            i->data = data;
+            i->font = font;
+            if (font) {
+                _measure(i);
+            }
+            _damage_item(i);
+            return id;
+        }
+    }
+    return SCENE_NONE;
+}
+
+uint8_t scene_line(int x0, int y0, int x1, int y1) {
+    return _add(KIND_LINE, x0, y0, x1, y1, NULL, NULL);
+}
+
+uint8_t scene_circle(int cx, int cy, uint8_t radius) {
+    return _add(KIND_CIRCLE, cx, cy, radius, 0, NULL, NULL);
+}
+
+uint8_t scene_rect(int x, int y, int w, int h) {
+    return _add(KIND_RECT, x, y, w, h, NULL, NULL);
+}
+
+uint8_t scene_text(const font_t *font, int x, int y, const char *s) {
+    return _add(KIND_TEXT, x, y, 0, 0, s, font);
+}
+
+uint8_t scene_text_p(const font_t *font, int x, int y, PGM_P s) {
+    return _add(KIND_TEXT_P, x, y, 0, 0, s, font);
+}
+
+uint8_t scene_bitmap_p(const uint8_t *bitmap, int x, int y, uint8_t w,
+        uint8_t h) {
+    return _add(KIND_BITMAP, x, y, w, h, bitmap, NULL);
+}
+
+//
+// The item with this id, or NULL if there is none
+static _item_t *_item(uint8_t id) {
+    if (id >= LCD_SCENE_ITEMS || _items[id].kind == KIND_FREE) {
+        return NULL;
+    }
+    return &_items[id];
+}
+
+void scene_remove(uint8_t id) {
+    _item_t *i = _item(id);
+    if (i) {
+        _damage_item(i);
+        i->kind = KIND_FREE;
+    }
+}
+
+void scene_move(uint8_t id, int dx, int dy) {
+    _item_t *i = _item(id);
+    if (!i) {
+        return;
+    }
+    _damage_item(i);
+    i->x += dx;
+    i->y += dy;
+    if (i->kind == KIND_LINE) {
+        i->a += dx;
+        i->b += dy;
+    }
+    _damage_item(i);
+}
+
+void scene_changed(uint8_t id) {
+    _item_t *i = _item(id);
+    if (!i) {
+        return;
+    }
+    _damage_item(i);
+    if (i->font) {
+        _measure(i);
+    }
+    _damage_item(i);
+}
+
+void scene_clear() {
+    for (uint8_t id = 0; id < LCD_SCENE_ITEMS; id++) {
+        scene_remove(id);
+    }
+}
+
+void scene_draw() {
+    for (uint8_t id = 0; id < LCD_SCENE_ITEMS; id++) {
+        _draw(&_items[id]);
+    }
+#if !LCD_BAND_ROWS
+    _damage_count = 0;
+#endif
+}
+
+#if !LCD_BAND_ROWS
+//
+// Redraw the damage. Marks made in d_dirty before now are kept, but of
+// those made here only the ones inside the damage are: outside it, items
+// are only drawn again over their own pixels.
+void scene_update() {
+    if (!_damage_count) {
+        return;
+    }
+    lcd_dirty_t before[LCD_BUFFER_ROWS];
+    memcpy(before, d_dirty, sizeof(before));
+    memset(d_dirty, 0, sizeof(d_dirty));
+
+    for (uint8_t d = 0; d < _damage_count; d++) {
+        _erase(&_damage[d]);
+    }
+    for (uint8_t id = 0; id < LCD_SCENE_ITEMS; id++) {
+        if (_items[id].kind != KIND_FREE && _damaged(&_items[id])) {
+            _draw(&_items[id]);
+        }
+    }
+
+    for (uint8_t y = 0; y < LCD_HEIGHT; y++) {
+        lcd_dirty_t mask = 0;
+        for (uint8_t d = 0; d < _damage_count; d++) {
+            const _rect_t *r = &_damage[d];
+            if (y >= r->y0 && y <= r->y1) {
+                mask |= display_span_mask(r->x0, r->x1);
+            }
+        }
+        d_dirty[y] = before[y] | (d_dirty[y] & mask);
+    }
+    _damage_count = 0;
+}
+#endif
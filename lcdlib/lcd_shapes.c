@@ -0,0 +1,237 @@
+/*
+ * lcd_shapes.c
+ *
+ * LCD Library filled shapes, ellipses and arcs.
+ *
+ * Every shape here is drawn as horizontal spans, one or two per scanline,
+ * each clipped once and then filled a byte at a time by display_span().
+ *
+ * Arcs are limited to a sector with two half plane tests. Along a
+ * scanline each test is a single comparison against x, so it cuts the
+ * span at one point rather than being made for every pixel.
+ */
+
+#include <avr/io.h>
+#include <avr/pgmspace.h>
+#include <inttypes.h>
+#include <stdbool.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "lcd.h"
+
+// sin(d) * 255 for d = 0 to 90 degrees
+static const uint8_t _sine[91] PROGMEM = {
+        0, 4, 9, 13, 18, 22, 27, 31, 35, 40, 44, 49,
+        53, 57, 62, 66, 70, 75, 79, 83, 87, 91, 96, 100,
+        104, 108, 112, 116, 120, 124, 127, 131, 135, 139, 143, 146,
+        150, 153, 157, 160, 164, 167, 171, 174, 177, 180, 183, 186,
+        190, 192, 195, 198, 201, 204, 206, 209, 211, 214, 216, 219,
+        221, 223, 225, 227, 229, 231, 233, 235, 236, 238, 240, 241,
+        243, 244, 245, 246, 247, 248, 249, 250, 251, 252, 253, 253,
+        254, 254, 254, 255, 255, 255, 255 };
+
+typedef struct {
+    int cx, cy; // centre
+    bool sector; // limit drawing to the sector below
+    bool wide; // sector is more than 180 degrees
+    int sx, sy; // direction of the start of the sector
+    int ex, ey; // opposite of the direction of the end of the sector
+} _shape_t;
+
+//
+// Unit vector, scaled by 255, at 'deg' degrees clockwise from 3 o'clock
+static void _direction(int deg, int *x, int *y) {
+    deg %= 360;
+    if (deg < 0) {
+        deg += 360;
+    }
+    if (deg <= 90) {
+        *x = pgm_read_byte(&_sine[90 - deg]);
+        *y = pgm_read_byte(&_sine[deg]);
+    } else if (deg <= 180) {
+        *x = -pgm_read_byte(&_sine[deg - 90]);
+        *y = pgm_read_byte(&_sine[180 - deg]);
+    } else if (deg <= 270) {
+        *x = -pgm_read_byte(&_sine[270 - deg]);
+        *y = -pgm_read_byte(&_sine[deg - 180]);
+    } else {
+        *x = pgm_read_byte(&_sine[deg - 270]);
+        *y = -pgm_read_byte(&_sine[360 - deg]);
+    }
+}
+
+//
+// Set up s to draw only from 'start' clockwise round to 'end' degrees.
+// Returns false if the sector is empty.
+static bool _sector(_shape_t *s, int start, int end) {
+    int sweep = end - start;
+    if (sweep >= 360 || sweep <= -360) {
+        s->sector = false;
+        return true;
+    }
+    sweep %= 360;
+    if (sweep < 0) {
+        sweep += 360;
+    }
+    if (!sweep) {
+        return false;
+    }
+    s->sector = true;
+    s->wide = sweep > 180;
+    _direction(start, &s->sx, &s->sy);
+    _direction(end, &s->ex, &s->ey);
+    s->ex = -s->ex;
+    s->ey = -s->ey;
+    return true;
+}
+
+// n / d rounded down, for d > 0
+static int _floor_div(long n, int d) {
+    return n >= 0 ? n / d : -((-n + d - 1) / d);
+}
+
+//
+// Narrow lo to hi to the points (x, dy) to the clockwise side of the
+// direction ax, ay, that is where ax * dy - ay * x >= 0
+static void _half(int ax, int ay, int dy, int *lo, int *hi) {
+    long n = (long) ax * dy;
+    if (ay > 0) {
+        int limit = _floor_div(n, ay);
+        if (*hi > limit) {
+            *hi = limit;
+        }
+    } else if (ay < 0) {
+        int limit = -_floor_div(n, -ay);
+        if (*lo < limit) {
+            *lo = limit;
+        }
+    } else if (n < 0) {
+        *hi = *lo - 1;
+    }
+}
+
+//
+// Set pixels x0 to x1 inclusive in row y, clipped to the screen
+static void _span(int x0, int x1, int y) {
+    if (y < 0 || y >= LCD_HEIGHT || x1 < 0 || x0 >= LCD_WIDTH || x0 > x1) {
+        return;
+    }
+    if (x0 < 0) {
+        x0 = 0;
+    }
+    if (x1 > LCD_WIDTH - 1) {
+        x1 = LCD_WIDTH - 1;
+    }
+    display_span(x0, x1, y);
+}
+
+//
+// Set pixels lo to hi of row dy, relative to the centre and limited to
+// the sector
+static void _row(const _shape_t *s, int dy, int lo, int hi) {
+    if (!s->sector) {
+        _span(s->cx + lo, s->cx + hi, s->cy + dy);
+        return;
+    }
+    int lo1 = lo, hi1 = hi, lo2 = lo, hi2 = hi;
+    _half(s->sx, s->sy, dy, &lo1, &hi1);
+    _half(s->ex, s->ey, dy, &lo2, &hi2);
+    if (s->wide) {
+        // Either side of the gap
+        _span(s->cx + lo1, s->cx + hi1, s->cy + dy);
+        _span(s->cx + lo2, s->cx + hi2, s->cy + dy);
+    } else {
+        // Between the two edges
+        _span(s->cx + (lo1 > lo2 ? lo1 : lo2), s->cx + (hi1 < hi2 ? hi1 : hi2),
+                s->cy + dy);
+    }
+}
+
+//
+// Draw the pixels a <= |x| <= b of row dy
+static void _ring_row(const _shape_t *s, int dy, int a, int b) {
+    if (a) {
+        _row(s, dy, -b, -a);
+        _row(s, dy, a, b);
+    } else {
+        _row(s, dy, -b, b);
+    }
+}
+
+//
+// Draw the pixels a <= |x| <= b of rows dy and -dy
+static void _rows(const _shape_t *s, int dy, int a, int b) {
+    _ring_row(s, dy, a, b);
+    if (dy) {
+        _ring_row(s, -dy, a, b);
+    }
+}
+
+//
+// Draw an ellipse with radii rx and ry, filled or as an outline.
+//
+// Row dy of the filled ellipse reaches out to the largest w with
+// w^2 ry^2 + dy^2 rx^2 <= rx^2 ry^2 + rx ry min(rx, ry). For a circle
+// that is w^2 + dy^2 <= r^2 + r, the midpoint test. The outline of a row
+// runs from just past the next row out to the edge, so it stays joined up.
+static void _ellipse(const _shape_t *s, uint8_t rx, uint8_t ry, bool fill) {
+    // Just fits 32 bits with radii of 255
+    uint32_t a2 = (uint32_t) rx * rx;
+    uint32_t b2 = (uint32_t) ry * ry;
+    uint32_t limit = a2 * b2 + (uint32_t) rx * ry * (rx < ry ? rx : ry);
+
+    int w = rx;
+    for (int dy = 0; dy <= ry; dy++) {
+        if (dy) {
+            while (w > 0 && (uint32_t) w * w * b2 + (uint32_t) dy * dy * a2
+                    > limit) {
+                w--;
+            }
+        }
+        if (fill) {
+            _rows(s, dy, 0, w);
+            continue;
+        }
+        // Width of the next row out
+        int next = 0;
+        if (dy < ry) {
+            next = w;
+            while (next > 0 && (uint32_t) next * next * b2
+                    + (uint32_t) (dy + 1) * (dy + 1) * a2 > limit) {
+                next--;
+            }
+            next = next + 1 < w ? next + 1 : w;
+        }
+        _rows(s, dy, next, w);
+    }
+}
+
+void display_fill_circle(int cx, int cy, uint8_t radius) {
+    _shape_t s = { cx, cy, false };
+    _ellipse(&s, radius, radius, true);
+}
+
+void display_ellipse(int cx, int cy, uint8_t rx, uint8_t ry) {
+    _shape_t s = { cx, cy, false };
+    _ellipse(&s, rx, ry, false);
+}
+
+void display_fill_ellipse(int cx, int cy, uint8_t rx, uint8_t ry) {
+    _shape_t s = { cx, cy, false };
+    _ellipse(&s, rx, ry, true);
+}
+
+void display_arc(int cx, int cy, uint8_t radius, int start, int end) {
+    _shape_t s = { cx, cy, false };
+    if (_sector(&s, start, end)) {
+        _ellipse(&s, radius, radius, false);
+    }
+}
+
+void display_fill_arc(int cx, int cy, uint8_t radius, int start, int end) {
+    _shape_t s = { cx, cy, false };
+    if (_sector(&s, start, end)) {
+        _ellipse(&s, radius, radius, true);
+    }
+}
@@ -36,3 +36,10 @@ void lcd_send_str_p(PGM_P p) {
         p++;
     }
 }
+
+void lcd_send_str(const char *s) {
+    while (*s) {
+        lcd_data(*s);
+        s++;
+    }
+}
@@ -0,0 +1,142 @@
+/*
+ * lcd_textbuf.c
+ *
+ * LCD Library shadow text screen.
+ *
+ * Text can be kept in t_buffer, a copy of the 4 line by 16 column screen.
+ * lcd_text_flush() sends only the parts of it which differ from what was
+ * last sent, so a status page where one digit changes costs one cell
+ * rather than the whole screen. Apart from lcd_text.c so that programs
+ * writing straight to DDRAM don't carry the two buffers.
+ */
+
+#include <avr/io.h>
+#include <avr/pgmspace.h>
+#include <inttypes.h>
+#include <stdarg.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "lcd.h"
+
+char t_buffer[LCD_TEXT_LINES][LCD_TEXT_COLS];
+
+//
+// What DDRAM holds, as far as we know
+static char _sent[LCD_TEXT_LINES][LCD_TEXT_COLS];
+
+void lcd_text_reset() {
+    memset(t_buffer, ' ', sizeof(t_buffer));
+    memset(_sent, ' ', sizeof(_sent));
+}
+
+void lcd_text_clear() {
+    memset(t_buffer, ' ', sizeof(t_buffer));
+}
+
+//
+// Copy up to n characters of s into t_buffer at line, col, stopping at the
+// end of the line. Returns the number copied.
+static uint8_t _put(uint8_t line, uint8_t col, const char *s, uint8_t n) {
+    if (line >= LCD_TEXT_LINES || col >= LCD_TEXT_COLS) {
+        return 0;
+    }
+    if (n > LCD_TEXT_COLS - col) {
+        n = LCD_TEXT_COLS - col;
+    }
+    memcpy(&t_buffer[line][col], s, n);
+    return n;
+}
+
+uint8_t lcd_text_printf(uint8_t line, uint8_t col, const char *fmt, ...) {
+    char buf[LCD_TEXT_COLS + 1];
+    va_list ap;
+    va_start(ap, fmt);
+    int n = vsnprintf(buf, sizeof(buf), fmt, ap);
+    va_end(ap);
+    return n > 0 ? _put(line, col, buf, n) : 0;
+}
+
+uint8_t lcd_text_printf_p(uint8_t line, uint8_t col, PGM_P fmt, ...) {
+    char buf[LCD_TEXT_COLS + 1];
+    va_list ap;
+    va_start(ap, fmt);
+    int n = vsnprintf_P(buf, sizeof(buf), fmt, ap);
+    va_end(ap);
+    return n > 0 ? _put(line, col, buf, n) : 0;
+}
+
+//
+// DDRAM has 32 cells of two characters. Addresses 0-7 are line 0, 8-15
+// line 2, 16-23 line 1 and 24-31 line 3, and the address counter steps
+// from each to the next after a cell is written.
+#define CELLS 32
+#define CELL_COLS (LCD_TEXT_COLS / 2)
+
+static char *_cell(char buf[][LCD_TEXT_COLS], uint8_t a) {
+    uint8_t line = ((a & 0x10) ? 1 : 0) | ((a & 0x08) ? 2 : 0);
+    return &buf[line][(a & 7) * 2];
+}
+
+static bool _changed(uint8_t a) {
+    const char *c = _cell(t_buffer, a);
+    const char *s = _cell(_sent, a);
+    return c[0] != s[0] || c[1] != s[1];
+}
+
+//
+// Modeled times, as for the graphics planner in lcd_graphics.c: setting
+// the address is one instruction, and a cell two bytes of a data block
+#if LCD_TIMING == LCD_TIMING_TABLE
+#define COST_ADDRESS (3 + LCD_ADDRESS_US)
+#define COST_CELL (2 * (2 + LCD_DATA_US))
+#else
+#define COST_ADDRESS (3 + 72)
+#define COST_CELL (2 * (2 + 40))
+#endif
+
+//
+// Send n cells from address a, a line at a time as t_buffer holds them
+static void _send_cells(uint8_t a, uint8_t n) {
+    lcd_instruction(0b10000000 | a);
+    while (n) {
+        uint8_t count = CELL_COLS - (a & 7);
+        if (count > n) {
+            count = n;
+        }
+        char *c = _cell(t_buffer, a);
+        lcd_data_block((const uint8_t *) c, count * 2);
+        memcpy(_cell(_sent, a), c, count * 2);
+        a += count;
+        n -= count;
+    }
+}
+
+//
+// Send each run of changed cells, running on through unchanged cells where
+// sending them is quicker than setting the address again
+void lcd_text_flush() {
+    uint8_t a = 0;
+    while (a < CELLS) {
+        if (!_changed(a)) {
+            a++;
+            continue;
+        }
+        // One past the last changed cell of the run
+        uint8_t end = a + 1;
+        while (end < CELLS) {
+            uint8_t gap = 0;
+            while (end + gap < CELLS && !_changed(end + gap)) {
+                gap++;
+            }
+            if (end + gap == CELLS || gap * COST_CELL > COST_ADDRESS) {
+                break;
+            }
+            end += gap + 1;
+        }
+        _send_cells(a, end - a);
+        a = end;
+    }
+}